@@ -0,0 +1,117 @@
+#! /bin/bash
+
+# compares the startup time and memory footprint of appimagelauncherd between two commits
+# the daemon is started with an empty home directory, and is considered to be up once it reports the directories it
+# watches, which all revisions of the daemon do after their initial scan, so any two commits can be compared
+
+if [[ "$1" == "" ]] || [[ "$2" == "" ]]; then
+    echo "Usage: bash $0 <base commit> <head commit> [runs]"
+    exit 2
+fi
+
+set -e
+
+# a private session bus makes sure no other daemon interferes with the measurements
+if [[ "$BENCHMARK_PRIVATE_BUS" != "0" ]]; then
+    if [[ "$BENCHMARK_NESTED" == "" ]]; then
+        BENCHMARK_NESTED=1 exec dbus-run-session -- bash "$0" "$@"
+    fi
+fi
+
+runs="${3:-10}"
+
+repo_root="$(readlink -f "$(dirname "$0")"/..)"
+
+TEMP_BASE=/tmp
+if [ -d /dev/shm ]; then
+    TEMP_BASE=/dev/shm
+fi
+
+BENCH_DIR="$(mktemp -d -p "$TEMP_BASE" appimagelauncherd-benchmark-XXXXXX)"
+
+cleanup () {
+    if [ -d "$BENCH_DIR" ]; then
+        rm -rf "$BENCH_DIR"
+    fi
+}
+
+trap cleanup EXIT
+
+build() {
+    local commit="$1"
+    local worktree="$BENCH_DIR"/src-"$commit"
+    local build_dir="$BENCH_DIR"/build-"$commit"
+
+    git -C "$repo_root" worktree add --detach "$worktree" "$commit" >/dev/null
+    git -C "$worktree" submodule update --init --recursive >/dev/null
+
+    cmake -S "$worktree" -B "$build_dir" -DCMAKE_BUILD_TYPE=RelWithDebInfo -DBUILD_TESTING=OFF >/dev/null
+    cmake --build "$build_dir" --target appimagelauncherd -j"$(nproc)" >/dev/null
+
+    git -C "$repo_root" worktree remove --force "$worktree"
+
+    echo "$build_dir"/src/daemon/appimagelauncherd
+}
+
+measure() {
+    local binary="$1"
+
+    export HOME="$BENCH_DIR"/home
+    rm -rf "$HOME"
+    mkdir -p "$HOME"/Applications
+
+    local log="$BENCH_DIR"/daemon.log
+    local start end pid rss
+
+    start="$(date +%s%N)"
+    "$binary" >"$log" 2>&1 &
+    pid="$!"
+
+    # wait for the daemon to finish its initial scan
+    until grep -q "Watching directories" "$log"; do
+        if ! kill -0 "$pid" 2>/dev/null; then
+            echo "Error: daemon exited prematurely, log:" >&2
+            cat "$log" >&2
+            return 1
+        fi
+        sleep 0.01
+    done
+
+    end="$(date +%s%N)"
+
+    rss="$(grep VmRSS /proc/"$pid"/status | awk '{print $2}')"
+
+    kill "$pid"
+    wait "$pid" || true
+
+    echo "$(( (end - start) / 1000000 )) $rss"
+}
+
+report() {
+    local name="$1"
+    local binary="$2"
+
+    local total_ms=0 total_rss=0 i ms rss
+
+    local result
+
+    for i in $(seq "$runs"); do
+        # measure runs in a subshell, so its failures must be checked explicitly
+        if ! result="$(measure "$binary")"; then
+            echo "Error: measurement of $name failed" >&2
+            exit 1
+        fi
+
+        read -r ms rss <<< "$result"
+        total_ms=$((total_ms + ms))
+        total_rss=$((total_rss + rss))
+    done
+
+    echo "$name: startup $((total_ms / runs)) ms, RSS $((total_rss / runs)) kB (average of $runs runs)"
+}
+
+base_binary="$(build "$1")"
+head_binary="$(build "$2")"
+
+report "$1" "$base_binary"
+report "$2" "$head_binary"
@@ -63,6 +63,7 @@ cmake_args=(
     "-DCPACK_DEBIAN_COMPATIBILITY_LEVEL=$DIST"
     "-DCI_BUILD=ON"
     "-DBUILD_TESTING=OFF"
+    "-DBUILD_TESTS=ON"
 )
 
 export QT_SELECT=qt5
@@ -103,6 +104,8 @@ fi
 nproc=1
 make -j "$nproc"
 
+ctest --output-on-failure
+
 # re-run cmake to find built shared objects with the globs, and update the CPack files
 cmake .
 
@@ -0,0 +1,74 @@
+# generates a C++ header containing the translations of the desktop actions AppImageLauncher adds to desktop files
+# the translations are read from the desktopfiles.<locale>.json files in I18N_DIR, and written to OUTPUT
+#
+# usage: cmake -DI18N_DIR=<dir> -DOUTPUT=<header> -P generate-desktop-file-translations.cmake
+#
+# the JSON files are flat objects mapping keys to strings, which are parsed with regular expressions, as string(JSON)
+# requires a more recent CMake than the project does
+
+if(NOT I18N_DIR OR NOT OUTPUT)
+    message(FATAL_ERROR "I18N_DIR and OUTPUT must be set")
+endif()
+
+file(GLOB JSON_FILES ${I18N_DIR}/desktopfiles.*.json)
+list(SORT JSON_FILES)
+
+# returns the value of the given key as a C string literal, or nullptr if the key doesn't exist
+function(find_translation contents key out_var)
+    set(regex "\"${key}\"[ \t\r\n]*:[ \t\r\n]*\"(([^\"\\\\]|\\\\.)*)\"")
+
+    if(contents MATCHES "${regex}")
+        # JSON allows escaping slashes, C++ doesn't; the other escape sequences are compatible
+        string(REPLACE "\\/" "/" value "${CMAKE_MATCH_1}")
+        set(${out_var} "\"${value}\"" PARENT_SCOPE)
+    else()
+        set(${out_var} "nullptr" PARENT_SCOPE)
+    endif()
+endfunction()
+
+set(entries "")
+
+foreach(JSON_FILE IN LISTS JSON_FILES)
+    get_filename_component(JSON_FILENAME ${JSON_FILE} NAME)
+
+    # parse locale from filename, skipping files like desktopfiles.a.b.json
+    if(NOT JSON_FILENAME MATCHES "^desktopfiles\\.([^.]+)\\.json$")
+        continue()
+    endif()
+
+    set(locale ${CMAKE_MATCH_1})
+
+    file(READ ${JSON_FILE} contents)
+
+    find_translation("${contents}" "Desktop Action remove/Name" remove_action_name)
+    find_translation("${contents}" "Desktop Action update/Name" update_action_name)
+
+    set(entries "${entries}    {\"${locale}\", ${remove_action_name}, ${update_action_name}},\n")
+endforeach()
+
+set(header "// generated by cmake/generate-desktop-file-translations.cmake from i18n/desktopfiles.*.json, do not edit
+
+#pragma once
+
+struct DesktopFileTranslation {
+    const char* locale;
+    // nullptr if there is no translation
+    const char* removeActionName;
+    const char* updateActionName;
+};
+
+// sorted by locale
+static const DesktopFileTranslation DESKTOP_FILE_TRANSLATIONS[] = {
+${entries}};
+")
+
+# don't touch the file if nothing has changed, to avoid needless rebuilds
+if(EXISTS ${OUTPUT})
+    file(READ ${OUTPUT} previous_header)
+
+    if(previous_header STREQUAL header)
+        return()
+    endif()
+endif()
+
+file(WRITE ${OUTPUT} "${header}")
@@ -7,6 +7,7 @@
 
 // local headers
 #include "CommandFactory.h"
+#include "shared_dbus.h"
 #include "exceptions.h"
 #include "logging.h"
 
@@ -18,6 +19,7 @@ int main(int argc, char** argv) {
     setenv("_FORCE_HEADLESS", "1", 1);
 
     QCoreApplication app(argc, argv);
+    installIconsChangedNotifier();
 
     std::ostringstream version;
     version << "version " << APPIMAGELAUNCHER_VERSION << " "
@@ -42,6 +44,7 @@ int main(int argc, char** argv) {
         qerr() << "Available commands:" << endl;
         qerr() << "  integrate    Integrate AppImages passed as commandline arguments" << endl;
         qerr() << "  unintegrate  Unintegrate AppImages passed as commandline arguments" << endl;
+        qerr() << "  stats        Print counters reported by the running daemon" << endl;
 
         return 2;
     }
@@ -61,6 +64,9 @@ int main(int argc, char** argv) {
     } catch (const UsageError& e) {
         qerr() << "Usage error: " << e.what() << endl;
         return 3;
+    } catch (const CliError& e) {
+        qerr() << "Error: " << e.what() << endl;
+        return 1;
     }
 
     return 0;
@@ -1,6 +1,7 @@
 // local headers
 #include "CommandFactory.h"
 #include "IntegrateCommand.h"
+#include "StatsCommand.h"
 #include "UnintegrateCommand.h"
 #include "exceptions.h"
 
@@ -13,6 +14,8 @@ namespace appimagelauncher {
                     return std::shared_ptr<Command>(new IntegrateCommand);
                 } else if (commandName == "unintegrate") {
                     return std::make_shared<UnintegrateCommand>();
+                } else if (commandName == "stats") {
+                    return std::make_shared<StatsCommand>();
                 }
 
                 throw CommandNotFoundError(commandName);
@@ -5,6 +5,7 @@
 #include "IntegrateCommand.h"
 #include "exceptions.h"
 #include "shared.h"
+#include "shared_dbus.h"
 #include "logging.h"
 
 namespace appimagelauncher {
@@ -27,6 +28,9 @@ namespace appimagelauncher {
                     path = QFileInfo(path).absoluteFilePath();
                 }
 
+                // AppImages which need to be (re-)integrated, at their final location
+                QStringList pathsToIntegrate;
+
                 for (const auto& pathToAppImage : arguments) {
                     qout() << "Processing " << pathToAppImage << endl;
 
@@ -76,6 +80,24 @@ namespace appimagelauncher {
                         qout() << "AppImage already in integration directory" << endl;
                     }
 
+                    pathsToIntegrate << pathToIntegratedAppImage;
+                }
+
+                if (pathsToIntegrate.empty())
+                    return;
+
+                // if the daemon is running, it integrates the AppImages for us, batched with the other work it's doing
+                switch (requestIntegrationFromDaemon(pathsToIntegrate)) {
+                    case DAEMON_REQUEST_SUCCEEDED:
+                        qout() << "AppImages integrated by appimagelauncherd" << endl;
+                        return;
+                    case DAEMON_REQUEST_FAILED:
+                        throw CliError("appimagelauncherd failed to integrate some of the AppImages");
+                    case DAEMON_UNAVAILABLE:
+                        break;
+                }
+
+                for (const auto& pathToIntegratedAppImage : pathsToIntegrate) {
                     installDesktopFileAndIcons(pathToIntegratedAppImage);
                 }
             }
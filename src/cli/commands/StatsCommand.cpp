@@ -0,0 +1,47 @@
+// library headers
+#include <QDBusConnection>
+#include <QDBusInterface>
+#include <QDBusReply>
+#include <QVariantMap>
+
+// local headers
+#include "StatsCommand.h"
+#include "daemondbusinterface.h"
+#include "exceptions.h"
+#include "logging.h"
+
+namespace appimagelauncher {
+    namespace cli {
+        namespace commands {
+            void StatsCommand::exec(QList<QString> arguments) {
+                if (!arguments.empty()) {
+                    throw InvalidArgumentsError("stats does not take any arguments");
+                }
+
+                QDBusInterface daemon(
+                    APPIMAGELAUNCHERD_DBUS_SERVICE,
+                    APPIMAGELAUNCHERD_DBUS_PATH,
+                    APPIMAGELAUNCHERD_DBUS_INTERFACE,
+                    QDBusConnection::sessionBus()
+                );
+
+                if (!daemon.isValid()) {
+                    throw CliError("Could not connect to appimagelauncherd (is it running?)");
+                }
+
+                QDBusReply<QVariantMap> reply = daemon.call("GetStatistics");
+
+                if (!reply.isValid()) {
+                    throw CliError("Failed to query statistics: " + reply.error().message());
+                }
+
+                // QVariantMap is sorted by key, so related counters are listed next to each other
+                const auto statistics = reply.value();
+
+                for (auto it = statistics.constBegin(); it != statistics.constEnd(); ++it) {
+                    qout() << it.key() << " " << it.value().toString() << endl;
+                }
+            }
+        }
+    }
+}
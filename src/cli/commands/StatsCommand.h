@@ -0,0 +1,17 @@
+#pragma once
+
+// local headers
+#include "Command.h"
+
+namespace appimagelauncher {
+    namespace cli {
+        namespace commands {
+            /**
+             * Prints the counters reported by a running appimagelauncherd.
+             */
+            class StatsCommand : public Command {
+                void exec(QList<QString> arguments) final;
+            };
+        }
+    }
+}
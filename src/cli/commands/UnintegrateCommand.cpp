@@ -5,6 +5,7 @@
 #include "UnintegrateCommand.h"
 #include "exceptions.h"
 #include "shared.h"
+#include "shared_dbus.h"
 #include "logging.h"
 
 namespace appimagelauncher {
@@ -27,6 +28,8 @@ namespace appimagelauncher {
                     path = QFileInfo(path).absoluteFilePath();
                 }
 
+                QStringList pathsToUnintegrate;
+
                 for (const auto& pathToAppImage : arguments) {
                     qout() << "Processing " << pathToAppImage << endl;
 
@@ -45,6 +48,24 @@ namespace appimagelauncher {
                         continue;
                     }
 
+                    pathsToUnintegrate << pathToAppImage;
+                }
+
+                if (pathsToUnintegrate.empty())
+                    return;
+
+                // if the daemon is running, it unintegrates the AppImages for us, batched with the other work it's doing
+                switch (requestUnintegrationFromDaemon(pathsToUnintegrate)) {
+                    case DAEMON_REQUEST_SUCCEEDED:
+                        qout() << "AppImages unintegrated by appimagelauncherd" << endl;
+                        return;
+                    case DAEMON_REQUEST_FAILED:
+                        throw CliError("appimagelauncherd failed to unintegrate some of the AppImages");
+                    case DAEMON_UNAVAILABLE:
+                        break;
+                }
+
+                for (const auto& pathToAppImage : pathsToUnintegrate) {
                     unregisterAppImage(pathToAppImage);
                 }
             }
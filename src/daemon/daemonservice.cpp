@@ -0,0 +1,165 @@
+// system includes
+#include <fstream>
+#include <iostream>
+#include <unistd.h>
+
+// library includes
+#include <QDBusConnection>
+#include <QDBusError>
+#include <QFileInfo>
+
+// local includes
+#include "daemonservice.h"
+#include "digestcache.h"
+#include "shared.h"
+
+// returns the resident set size of the current process in bytes, or -1 if it can't be determined
+static qint64 residentSetSize() {
+    std::ifstream statm("/proc/self/statm");
+
+    long totalPages = 0, residentPages = 0;
+
+    if (!(statm >> totalPages >> residentPages))
+        return -1;
+
+    return static_cast<qint64>(residentPages) * sysconf(_SC_PAGESIZE);
+}
+
+DaemonService::DaemonService(Worker* worker, FileSystemWatcher* watcher, EventThrottle* throttle,
+                             std::shared_ptr<DaemonMetrics> metrics, QObject* parent) : QObject(parent),
+                                                                                        worker(worker),
+                                                                                        watcher(watcher),
+                                                                                        throttle(throttle),
+                                                                                        metrics(std::move(metrics)) {
+    connect(worker, &Worker::operationCompleted, this, &DaemonService::operationCompleted);
+}
+
+bool DaemonService::registerOnSessionBus() {
+    auto connection = QDBusConnection::sessionBus();
+
+    if (!connection.isConnected()) {
+        std::cerr << "Could not connect to session bus: "
+                  << connection.lastError().message().toStdString() << std::endl;
+        return false;
+    }
+
+    if (!connection.registerService(APPIMAGELAUNCHERD_DBUS_SERVICE)) {
+        std::cerr << "Could not register D-Bus service " << APPIMAGELAUNCHERD_DBUS_SERVICE << ": "
+                  << connection.lastError().message().toStdString() << std::endl;
+        return false;
+    }
+
+    if (!connection.registerObject(APPIMAGELAUNCHERD_DBUS_PATH, this, QDBusConnection::ExportScriptableSlots)) {
+        std::cerr << "Could not register D-Bus object " << APPIMAGELAUNCHERD_DBUS_PATH << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+QVariantMap DaemonService::GetStatistics() const {
+    auto statistics = metrics->toVariantMap();
+
+    statistics["queue_depth"] = worker->queueDepth();
+
+    statistics["inotify.wakeups"] = static_cast<qulonglong>(watcher->wakeups());
+    statistics["inotify.idle_wakeups"] = static_cast<qulonglong>(watcher->idleWakeups());
+    statistics["inotify.events_read"] = static_cast<qulonglong>(watcher->eventsRead());
+    statistics["inotify.queue_overflows"] = static_cast<qulonglong>(watcher->queueOverflows());
+    statistics["inotify.watches"] = watcher->watchCount();
+    statistics["inotify.watch_budget"] = watcher->watchBudget();
+    statistics["inotify.unwatched_directories"] = watcher->unwatchedDirectoryCount();
+
+    statistics["events.received"] = throttle->eventsReceived();
+    statistics["events.coalesced"] = throttle->eventsCoalesced();
+    statistics["events.dropped"] = throttle->eventsDropped();
+    statistics["events.forwarded"] = throttle->eventsForwarded();
+    statistics["events.buffered"] = throttle->bufferedEvents();
+    statistics["events.rescans"] = throttle->rescansRequested();
+
+    const auto& digestCache = DigestCache::defaultCache();
+    statistics["digest_cache.hits"] = static_cast<qulonglong>(digestCache.hits());
+    statistics["digest_cache.misses"] = static_cast<qulonglong>(digestCache.misses());
+
+    statistics["process.rss_bytes"] = residentSetSize();
+
+    return statistics;
+}
+
+bool DaemonService::acceptRequest(const QStringList& paths, bool waitForCompletion) {
+    // the daemon's working directory is unrelated to the client's, therefore relative paths can't be resolved
+    for (const auto& path : paths) {
+        if (!QFileInfo(path).isAbsolute()) {
+            sendErrorReply(QDBusError::InvalidArgs, "Not an absolute path: " + path);
+            return false;
+        }
+    }
+
+    if (waitForCompletion && !paths.empty()) {
+        setDelayedReply(true);
+        pendingRequests.push_back({message(), paths.toSet(), true, worker->currentGeneration()});
+    }
+
+    return true;
+}
+
+bool DaemonService::Integrate(const QStringList& paths, bool waitForCompletion) {
+    if (!acceptRequest(paths, waitForCompletion))
+        return false;
+
+    for (const auto& path : paths) {
+        worker->requestIntegration(path);
+    }
+
+    // ignored in case of a delayed reply
+    return true;
+}
+
+bool DaemonService::Unintegrate(const QStringList& paths, bool waitForCompletion) {
+    if (!acceptRequest(paths, waitForCompletion))
+        return false;
+
+    for (const auto& path : paths) {
+        worker->requestUnintegration(path);
+    }
+
+    // ignored in case of a delayed reply
+    return true;
+}
+
+QVariantMap DaemonService::GetStatus(const QString& path) const {
+    QVariantMap status;
+
+    status["pending"] = worker->isPending(path);
+    status["integrated"] = hasAlreadyBeenIntegrated(path);
+
+    return status;
+}
+
+void DaemonService::Rescan() {
+    emit rescanRequested();
+}
+
+void DaemonService::operationCompleted(const QString& path, bool success, quint64 generation) {
+    auto it = pendingRequests.begin();
+
+    while (it != pendingRequests.end()) {
+        // an operation for the same path which was running already when the request was received may have worked on
+        // an older state of the file, the request is answered once the operation it has scheduled has been executed
+        if (generation <= it->generation || !it->remainingPaths.remove(path)) {
+            ++it;
+            continue;
+        }
+
+        if (!success)
+            it->success = false;
+
+        if (!it->remainingPaths.empty()) {
+            ++it;
+            continue;
+        }
+
+        QDBusConnection::sessionBus().send(it->message.createReply(it->success));
+        it = pendingRequests.erase(it);
+    }
+}
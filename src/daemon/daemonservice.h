@@ -0,0 +1,86 @@
+// system includes
+#include <list>
+#include <memory>
+
+// library includes
+#include <QDBusContext>
+#include <QDBusMessage>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+#include <QVariantMap>
+
+// local includes
+#include "daemondbusinterface.h"
+#include "eventthrottle.h"
+#include "filesystemwatcher.h"
+#include "metrics.h"
+#include "worker.h"
+
+#pragma once
+
+/**
+ * Control and introspection interface of the daemon, provided on the session bus.
+ *
+ * Clients such as the CLI can hand integrations over to the daemon, which adds them to the worker's queue, so that
+ * requests from many short-lived clients are executed in batches.
+ *
+ * The methods are called from the main thread's event loop, and must therefore return quickly. Replies to requests
+ * waiting for their completion are sent asynchronously.
+ */
+class DaemonService : public QObject, protected QDBusContext {
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", APPIMAGELAUNCHERD_DBUS_INTERFACE)
+
+private:
+    // a request whose reply is sent once all its operations have been executed
+    struct PendingRequest {
+        QDBusMessage message;
+        QSet<QString> remainingPaths;
+        bool success;
+        // operations started up to this generation were running already, and don't belong to the request
+        quint64 generation;
+    };
+
+    Worker* worker;
+    FileSystemWatcher* watcher;
+    EventThrottle* throttle;
+    std::shared_ptr<DaemonMetrics> metrics;
+
+    std::list<PendingRequest> pendingRequests;
+
+public:
+    DaemonService(Worker* worker, FileSystemWatcher* watcher, EventThrottle* throttle,
+                  std::shared_ptr<DaemonMetrics> metrics, QObject* parent = nullptr);
+
+    // registers the service and this object on the session bus
+    // returns false if that fails, e.g., because there is no session bus or another daemon is running already
+    bool registerOnSessionBus();
+
+private:
+    // validates the paths, and sets up a delayed reply if the client wants to wait for the operations
+    // returns false if the request has been rejected (in that case, an error reply has been sent already)
+    bool acceptRequest(const QStringList& paths, bool waitForCompletion);
+
+public slots:
+    // returns the daemon's current counters as flat key-value pairs
+    Q_SCRIPTABLE QVariantMap GetStatistics() const;
+
+    // schedule the given AppImages for (un)integration
+    // if waitForCompletion is set, the reply is sent once all of them have been processed, and is true if all of the
+    // operations succeeded; otherwise, the reply is sent right away
+    Q_SCRIPTABLE bool Integrate(const QStringList& paths, bool waitForCompletion);
+    Q_SCRIPTABLE bool Unintegrate(const QStringList& paths, bool waitForCompletion);
+
+    // returns whether an operation is pending for the given path, and whether it has been integrated
+    Q_SCRIPTABLE QVariantMap GetStatus(const QString& path) const;
+
+    // rescans all watched directories, e.g., when events are suspected to have been lost
+    Q_SCRIPTABLE void Rescan();
+
+private slots:
+    void operationCompleted(const QString& path, bool success, quint64 generation);
+
+signals:
+    void rescanRequested();
+};
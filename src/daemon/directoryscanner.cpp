@@ -0,0 +1,360 @@
+// system includes
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <set>
+#include <sys/stat.h>
+
+// library includes
+#include <QDebug>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <appimage/appimage.h>
+
+// local includes
+#include "directoryscanner.h"
+#include "scanstate.h"
+#include "shared.h"
+
+static qint64 mTimeNs(const struct stat& st) {
+    return st.st_mtim.tv_sec * 1000000000ll + st.st_mtim.tv_nsec;
+}
+
+// type as returned by appimage_get_type(...)
+static bool isAppImageType(int type) {
+    return 0 < type && type <= 2;
+}
+
+class DirectoryScanner::PrivateData {
+public:
+    // shared by all directories of a single call to scan(...)
+    struct ScanJob {
+        std::atomic<int> pendingDirectories{0};
+
+        // the directories passed to scan(...)
+        std::set<QString> roots;
+        bool allRoots = false;
+
+        // directories which exist and have been visited, the state of all others within the roots is dropped
+        QMutex reachedDirectoriesMutex;
+        std::set<QString> reachedDirectories;
+    };
+
+    // tracks the tasks belonging to a single directory
+    // the task that finishes last records the results in the scan state
+    struct DirectoryJob {
+        QDir dir;
+        QString dirPath;
+        bool skipIfUnchanged;
+        std::shared_ptr<ScanJob> scanJob;
+
+        QElapsedTimer timer;
+
+        // the listing task itself counts as a pending task
+        std::atomic<int> pendingTasks{1};
+
+        // results of the previous scan, if any
+        std::shared_ptr<ScanState::Directory> previousState;
+
+        // collects the results of this scan
+        QMutex newStateMutex;
+        ScanState::Directory newState;
+        bool listed = false;
+    };
+
+    class ProbeTask : public QRunnable {
+    private:
+        PrivateData* d;
+        std::shared_ptr<DirectoryJob> job;
+        QString path;
+        QString fileName;
+        ScanState::Entry entry;
+        // whether the file has been seen by a previous scan, and has changed since
+        bool modified;
+
+    public:
+        ProbeTask(PrivateData* d, std::shared_ptr<DirectoryJob> job, QString path, QString fileName,
+                  ScanState::Entry entry, bool modified) : d(d), job(std::move(job)), path(std::move(path)),
+                                                           fileName(std::move(fileName)), entry(entry),
+                                                           modified(modified) {}
+
+        void run() override {
+            const auto appImageType = appimage_get_type(path.toStdString().c_str(), false);
+            const auto isAppImage = isAppImageType(appImageType);
+
+            entry.type = appImageType;
+
+            {
+                QMutexLocker lock(&job->newStateMutex);
+                job->newState.entries.emplace(fileName, entry);
+            }
+
+            // an AppImage updated in place has to be reintegrated even if it has been integrated already, as the
+            // events for the update might have been lost (which is why rescans are run)
+            if (isAppImage && modified) {
+                d->log("Found AppImage which has been modified since the last scan: " + path);
+                emit d->scanner->appImageFound(path, entry.size);
+            } else if (isAppImage) {
+                d->checkIntegration(path, entry.size, true);
+            }
+
+            d->finishTask(job);
+        }
+    };
+
+    class ListDirectoryTask : public QRunnable {
+    private:
+        PrivateData* d;
+        std::shared_ptr<DirectoryJob> job;
+
+    public:
+        ListDirectoryTask(PrivateData* d, std::shared_ptr<DirectoryJob> job) : d(d), job(std::move(job)) {}
+
+        void run() override {
+            struct stat dirStat{};
+            if (stat(job->dirPath.toStdString().c_str(), &dirStat) != 0) {
+                d->log("Directory does not exist, skipping: " + job->dirPath);
+                d->finishTask(job);
+                return;
+            }
+
+            {
+                QMutexLocker lock(&job->scanJob->reachedDirectoriesMutex);
+                job->scanJob->reachedDirectories.insert(job->dirPath);
+            }
+
+            // if no files have been added, removed or renamed since the last scan, we don't need to look at the
+            // directory at all
+            // its subdirectories might have changed, though
+            if (job->skipIfUnchanged && job->previousState != nullptr &&
+                job->previousState->mtimeNs == mTimeNs(dirStat)) {
+                d->log("Directory unchanged since last scan, skipping: " + job->dirPath);
+
+                // the AppImages in there might still need to be (re-)integrated, e.g., if a previous integration
+                // failed or the desktop file has been removed in the meantime
+                for (const auto& entryPair : job->previousState->entries) {
+                    if (isAppImageType(entryPair.second.type))
+                        d->checkIntegration(job->dir.absoluteFilePath(entryPair.first), entryPair.second.size, false);
+                }
+
+                for (const auto& subdirectoryName : job->previousState->subdirectories) {
+                    d->startDirectoryJob(job->scanJob, QDir(job->dir.absoluteFilePath(subdirectoryName)),
+                                         job->skipIfUnchanged);
+                }
+
+                d->finishTask(job);
+                return;
+            }
+
+            d->log("Searching directory: " + job->dirPath);
+
+            {
+                QMutexLocker lock(&job->newStateMutex);
+                job->newState.mtimeNs = mTimeNs(dirStat);
+                job->listed = true;
+            }
+
+            for (QDirIterator it(job->dir); it.hasNext();) {
+                const auto& path = it.next();
+
+                struct stat fileStat{};
+                if (stat(path.toStdString().c_str(), &fileStat) != 0)
+                    continue;
+
+                if (S_ISDIR(fileStat.st_mode)) {
+                    // symlinks to directories aren't followed, as they might form loops
+                    // hidden directories aren't searched either, like the file system watcher doesn't watch them
+                    if (it.fileInfo().isSymLink() || it.fileName().startsWith('.'))
+                        continue;
+
+                    {
+                        QMutexLocker lock(&job->newStateMutex);
+                        job->newState.subdirectories.insert(it.fileName());
+                    }
+
+                    d->startDirectoryJob(job->scanJob, QDir(path), job->skipIfUnchanged);
+                    continue;
+                }
+
+                if (!S_ISREG(fileStat.st_mode))
+                    continue;
+
+                ScanState::Entry entry{fileStat.st_ino, fileStat.st_size, mTimeNs(fileStat), -1};
+                bool modified = false;
+
+                // files which haven't changed since the last scan have been handled back then already
+                if (job->previousState != nullptr) {
+                    const auto& previousEntries = job->previousState->entries;
+                    const auto previousEntry = previousEntries.find(it.fileName());
+
+                    if (previousEntry != previousEntries.end())
+                        modified = !previousEntry->second.isSameFileAs(entry);
+
+                    if (previousEntry != previousEntries.end() && !modified) {
+                        entry.type = previousEntry->second.type;
+
+                        {
+                            QMutexLocker lock(&job->newStateMutex);
+                            job->newState.entries.emplace(it.fileName(), entry);
+                        }
+
+                        // the file doesn't need to be probed again, but its integration might have failed or been
+                        // removed since the last scan, which is cheap to check
+                        if (isAppImageType(entry.type))
+                            d->checkIntegration(path, entry.size, false);
+
+                        continue;
+                    }
+                }
+
+                // probing files requires reading from them, which is done in parallel to listing the directory
+                ++job->pendingTasks;
+                d->pool.start(new ProbeTask(d, job, path, it.fileName(), entry, modified));
+            }
+
+            d->finishTask(job);
+        }
+    };
+
+public:
+    DirectoryScanner* const scanner;
+
+    QMutex scanStateMutex;
+    ScanState scanState;
+
+    QMutex outputMutex;
+
+    // must be the last member, so that it's destroyed (and waits for the running tasks) before any other member
+    QThreadPool pool;
+
+public:
+    PrivateData(DirectoryScanner* scanner, const QString& scanStatePath, const QString& stamp) :
+        scanner(scanner),
+        scanState(scanStatePath, stamp) {
+        scanState.load();
+
+        // the tasks are mostly I/O bound, but we don't want to thrash the disks either
+        pool.setMaxThreadCount(std::max(2, QThread::idealThreadCount()));
+    }
+
+    // scans the given directory in the background as part of the given scan job
+    void startDirectoryJob(const std::shared_ptr<ScanJob>& scanJob, const QDir& dir, bool skipIfUnchanged) {
+        auto job = std::make_shared<DirectoryJob>();
+        job->dir = dir;
+        job->dirPath = dir.absolutePath();
+        job->skipIfUnchanged = skipIfUnchanged;
+        job->scanJob = scanJob;
+        job->timer.start();
+
+        {
+            QMutexLocker lock(&scanStateMutex);
+
+            const auto* previousState = scanState.directory(job->dirPath);
+
+            if (previousState != nullptr)
+                job->previousState = std::make_shared<ScanState::Directory>(*previousState);
+        }
+
+        // must be incremented before the task is started, otherwise the scan job might finish before this directory
+        // has been scanned
+        ++scanJob->pendingDirectories;
+
+        pool.start(new ListDirectoryTask(this, job));
+    }
+
+    void log(const QString& message) {
+        QMutexLocker lock(&outputMutex);
+        std::cout << message.toStdString() << std::endl;
+    }
+
+    // reports the AppImage if it needs to be (re-)integrated
+    void checkIntegration(const QString& path, qint64 size, bool logSkipped) {
+        // at application startup, we don't want to integrate AppImages that have been integrated already,
+        // as that it slows down very much
+        // the integration will be updated as soon as any of these AppImages is run with AppImageLauncher
+        if (!hasAlreadyBeenIntegrated(path)) {
+            log("Found AppImage which is not integrated yet: " + path);
+            emit scanner->appImageFound(path, size);
+        } else if (!desktopFileHasBeenUpdatedSinceLastUpdate(path)) {
+            log("Found AppImage which has been integrated already but needs to be reintegrated: " + path);
+            emit scanner->appImageFound(path, size);
+        } else if (logSkipped) {
+            log("Found AppImage which is integrated already, skipping: " + path);
+        }
+    }
+
+    void finishTask(const std::shared_ptr<DirectoryJob>& job) {
+        if (--job->pendingTasks > 0)
+            return;
+
+        // all tasks of this directory have finished, so we can record the results
+        // in case the directory has been skipped, the previous results remain valid
+        const auto durationMs = job->timer.elapsed();
+
+        if (job->listed) {
+            QMutexLocker lock(&scanStateMutex);
+            scanState.setDirectory(job->dirPath, std::move(job->newState));
+        }
+
+        emit scanner->directoryScanned(job->dirPath, durationMs);
+
+        finishScanJob(job->scanJob);
+    }
+
+    void finishScanJob(const std::shared_ptr<ScanJob>& scanJob) {
+        if (--scanJob->pendingDirectories > 0)
+            return;
+
+        {
+            QMutexLocker lock(&scanStateMutex);
+
+            // all tasks have finished, so the reached directories don't change any more
+            scanState.pruneDirectories(scanJob->roots, scanJob->reachedDirectories, scanJob->allRoots);
+
+            if (!scanState.save()) {
+                std::cerr << "Warning: failed to save scan state" << std::endl;
+            }
+        }
+
+        emit scanner->finished();
+    }
+};
+
+DirectoryScanner::DirectoryScanner(const QString& scanStatePath, const QString& stamp) {
+    d = std::make_shared<PrivateData>(this, scanStatePath, stamp);
+}
+
+DirectoryScanner::~DirectoryScanner() {
+    // the tasks emit signals on this object, therefore we have to wait for them before it's gone
+    d->pool.waitForDone();
+}
+
+void DirectoryScanner::scan(const QDirSet& directories, bool skipUnchangedDirectories, bool allDirectories) {
+    if (directories.empty()) {
+        emit finished();
+        return;
+    }
+
+    std::cout << "Searching for existing AppImages" << std::endl;
+
+    auto scanJob = std::make_shared<PrivateData::ScanJob>();
+    scanJob->allRoots = allDirectories;
+
+    for (const auto& dir : directories)
+        scanJob->roots.insert(dir.absolutePath());
+
+    // subdirectories are added to the scan job while it's running, therefore the job must not finish before all
+    // top level directories have been started
+    ++scanJob->pendingDirectories;
+
+    for (const auto& dir : directories) {
+        d->startDirectoryJob(scanJob, dir, skipUnchangedDirectories);
+    }
+
+    d->finishScanJob(scanJob);
+}
@@ -0,0 +1,59 @@
+// system includes
+#include <memory>
+
+// library includes
+#include <QObject>
+#include <QString>
+
+// local includes
+#include "types.h"
+
+#pragma once
+
+/**
+ * Searches directories and their subdirectories (except for hidden ones) for AppImages which need to be
+ * (re-)integrated.
+ *
+ * Scans run in the background on a bounded thread pool. Listing a directory, probing the files in there and checking
+ * whether they have been integrated already are separate tasks in the pool's queue, so idle threads pick up work from
+ * any directory (or mount) currently being scanned, and slow devices don't hold up fast ones.
+ *
+ * AppImages are reported through appImageFound(...) as soon as they have been found, so integration can start while
+ * the scan is still running.
+ *
+ * The results are recorded in a persistent ScanState, which allows for skipping unchanged directories and files.
+ */
+class DirectoryScanner : public QObject {
+    Q_OBJECT
+
+private:
+    class PrivateData;
+    std::shared_ptr<PrivateData> d;
+
+public:
+    // the scan state is loaded from and saved to scanStatePath
+    // it is discarded whenever the stamp changes (see ScanState)
+    DirectoryScanner(const QString& scanStatePath, const QString& stamp);
+    ~DirectoryScanner() override;
+
+public slots:
+    // starts scanning the given directories in the background
+    // when skipUnchangedDirectories is set, directories whose modification time didn't change since the last scan are
+    // skipped entirely
+    // this is not sufficient when events might have been lost, as files modified in place don't change the
+    // modification time of their directory
+    // the scan state of directories within the given ones which don't exist any more is dropped; if allDirectories is
+    // set, the given directories are all directories which are scanned, and the state of any others is dropped, too
+    void scan(const QDirSet& directories, bool skipUnchangedDirectories = true, bool allDirectories = false);
+
+signals:
+    // emitted for every AppImage that needs to be (re-)integrated
+    // the size allows for integrating small AppImages first
+    void appImageFound(QString path, qint64 size);
+
+    // emitted when a directory has been scanned completely
+    void directoryScanned(QString path, qint64 durationMs);
+
+    // emitted when all directories passed to a call of scan(...) have been scanned
+    void finished();
+};
@@ -0,0 +1,164 @@
+// system includes
+#include <algorithm>
+#include <iostream>
+
+// library includes
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QSet>
+#include <QTimer>
+
+// local includes
+#include "eventthrottle.h"
+#include "pendingoperations.h"
+
+// events are forwarded in small portions, so that the event loop stays responsive
+static const int FLUSH_INTERVAL = 100;
+
+// dirty directories are rescanned once no events have been dropped for this long
+static const int RESCAN_DELAY = 2 * 1000;
+// but no later than this after the first event has been dropped, as the events might never stop (e.g., while a large
+// file is being written)
+static const int MAX_RESCAN_DELAY = 30 * 1000;
+
+class EventThrottle::PrivateData {
+public:
+    const int capacity;
+    const int eventsPerFlush;
+
+    // coalesces the events per path, keeping the order in which they arrived
+    PendingOperations buffer;
+
+    QSet<QString> dirtyDirectories;
+
+    QTimer flushTimer;
+    QTimer rescanTimer;
+    // started when the first directory has become dirty
+    QElapsedTimer dirtySince;
+
+    quint64 received = 0;
+    quint64 coalesced = 0;
+    quint64 dropped = 0;
+    quint64 forwarded = 0;
+    quint64 rescans = 0;
+
+public:
+    PrivateData(int capacity, int rate) : capacity(std::max(1, capacity)),
+                                          eventsPerFlush(std::max(1, rate * FLUSH_INTERVAL / 1000)) {
+        flushTimer.setInterval(FLUSH_INTERVAL);
+
+        rescanTimer.setSingleShot(true);
+        rescanTimer.setInterval(RESCAN_DELAY);
+    }
+
+    // (re-)starts the rescan delay, unless the maximum delay would be exceeded
+    void scheduleRescan() {
+        const auto remaining = MAX_RESCAN_DELAY - dirtySince.elapsed();
+        rescanTimer.start(static_cast<int>(std::max<qint64>(0, std::min<qint64>(RESCAN_DELAY, remaining))));
+    }
+
+    // buffers the event, unless it has to be dropped
+    void add(const QString& path, OP_TYPE type) {
+        ++received;
+
+        // the rescan will pick up the change anyway
+        if (!dirtyDirectories.empty() && dirtyDirectories.contains(QFileInfo(path).absolutePath())) {
+            ++dropped;
+            scheduleRescan();
+            return;
+        }
+
+        if (!buffer.contains(path) && buffer.size() >= capacity) {
+            if (dirtyDirectories.empty()) {
+                std::cerr << "Warning: too many file system events, rescanning affected directories later" << std::endl;
+                dirtySince.start();
+            }
+
+            ++dropped;
+            dirtyDirectories.insert(QFileInfo(path).absolutePath());
+            scheduleRescan();
+            return;
+        }
+
+        if (buffer.schedule(path, type) != PendingOperations::ADDED)
+            ++coalesced;
+    }
+};
+
+EventThrottle::EventThrottle(int capacity, int rate, QObject* parent)
+    : QObject(parent), d(std::make_shared<PrivateData>(capacity, rate)) {
+    connect(&d->flushTimer, &QTimer::timeout, this, [this]() {
+        auto budget = d->eventsPerFlush;
+
+        const auto events = d->buffer.takeIf([&budget](const Operation&) {
+            return budget-- > 0;
+        });
+
+        d->forwarded += events.size();
+
+        for (const auto& event : events) {
+            const auto& operation = event.first;
+
+            if (operation.second == INTEGRATE) {
+                emit fileChanged(operation.first);
+            } else {
+                emit fileRemoved(operation.first);
+            }
+        }
+
+        if (d->buffer.empty())
+            d->flushTimer.stop();
+    });
+
+    connect(&d->rescanTimer, &QTimer::timeout, this, [this]() {
+        QDirSet directories;
+
+        for (const auto& path : d->dirtyDirectories)
+            directories.insert(QDir(path));
+
+        d->dirtyDirectories.clear();
+        ++d->rescans;
+
+        emit directoriesNeedRescan(directories);
+    });
+}
+
+void EventThrottle::addChangedFiles(const QStringList& paths) {
+    for (const auto& path : paths)
+        d->add(path, INTEGRATE);
+
+    if (!d->buffer.empty() && !d->flushTimer.isActive())
+        d->flushTimer.start();
+}
+
+void EventThrottle::addRemovedFiles(const QStringList& paths) {
+    for (const auto& path : paths)
+        d->add(path, UNINTEGRATE);
+
+    if (!d->buffer.empty() && !d->flushTimer.isActive())
+        d->flushTimer.start();
+}
+
+quint64 EventThrottle::eventsReceived() const {
+    return d->received;
+}
+
+quint64 EventThrottle::eventsCoalesced() const {
+    return d->coalesced;
+}
+
+quint64 EventThrottle::eventsDropped() const {
+    return d->dropped;
+}
+
+quint64 EventThrottle::eventsForwarded() const {
+    return d->forwarded;
+}
+
+quint64 EventThrottle::rescansRequested() const {
+    return d->rescans;
+}
+
+int EventThrottle::bufferedEvents() const {
+    return d->buffer.size();
+}
@@ -0,0 +1,70 @@
+// system includes
+#include <memory>
+
+// library includes
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+// local includes
+#include "types.h"
+
+#pragma once
+
+/**
+ * Bounded buffer between the file system watcher and the worker.
+ *
+ * Tools like rsync or git can cause hundreds of thousands of events within a few seconds, most of which concern the
+ * same few files. The events are therefore collected in a buffer first, where repeated events for the same path are
+ * coalesced, and forwarded to the worker at a limited rate.
+ *
+ * When the buffer is full, further events are dropped, and the directories they belong to are marked dirty instead.
+ * Once the flood has calmed down, or after 30 seconds at the latest, these directories are reported through
+ * directoriesNeedRescan(...), so that no changes are lost.
+ */
+class EventThrottle : public QObject {
+    Q_OBJECT
+
+public:
+    // maximum number of paths buffered
+    static constexpr int DEFAULT_CAPACITY = 4096;
+    // maximum number of events forwarded per second
+    static constexpr int DEFAULT_RATE = 500;
+
+private:
+    class PrivateData;
+    std::shared_ptr<PrivateData> d;
+
+public:
+    explicit EventThrottle(int capacity = DEFAULT_CAPACITY, int rate = DEFAULT_RATE, QObject* parent = nullptr);
+
+public:
+    // number of events received from the watcher
+    quint64 eventsReceived() const;
+
+    // number of events merged into an event already buffered for the same path
+    quint64 eventsCoalesced() const;
+
+    // number of events dropped because the buffer was full, or their directory had been marked dirty already
+    quint64 eventsDropped() const;
+
+    // number of events passed on to the worker
+    quint64 eventsForwarded() const;
+
+    // number of rescans requested because events have been dropped
+    quint64 rescansRequested() const;
+
+    // number of events currently buffered
+    int bufferedEvents() const;
+
+public slots:
+    void addChangedFiles(const QStringList& paths);
+    void addRemovedFiles(const QStringList& paths);
+
+signals:
+    void fileChanged(QString path);
+    void fileRemoved(QString path);
+
+    // emitted when events for these directories have been dropped
+    void directoriesNeedRescan(QDirSet set);
+};
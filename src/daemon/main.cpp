@@ -1,6 +1,7 @@
 // system includes
 #include <deque>
 #include <iostream>
+#include <memory>
 #include <set>
 #include <sstream>
 #include <sys/stat.h>
@@ -10,12 +11,21 @@
 #include <QCoreApplication>
 #include <QDebug>
 #include <QDirIterator>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
 #include <QTimer>
 #include <appimage/appimage.h>
 
 // local includes
 #include "shared.h"
+#include "shared_dbus.h"
+#include "daemonservice.h"
+#include "directoryscanner.h"
+#include "eventthrottle.h"
 #include "filesystemwatcher.h"
+#include "metrics.h"
+#include "mountmonitor.h"
+#include "scanstate.h"
 #include "worker.h"
 
 #define UPDATE_WATCHED_DIRECTORIES_INTERVAL 30 * 1000
@@ -57,41 +67,6 @@ QTimer* setupBinaryUpdatesMonitor(char* const* argv) {
     return timer;
 }
 
-void initialSearchForAppImages(const QDirSet& dirsToSearch, Worker& worker) {
-    // initial search for AppImages; if AppImages are found, they will be integrated, unless they already are
-    std::cout << "Searching for existing AppImages" << std::endl;
-
-    for (const auto& dir : dirsToSearch) {
-        std::cout << "Searching directory: " << dir.absolutePath().toStdString() << std::endl;
-
-        for (QDirIterator it(dir); it.hasNext();) {
-            const auto& path = it.next();
-
-            if (QFileInfo(path).isFile()) {
-                const auto appImageType = appimage_get_type(path.toStdString().c_str(), false);
-                const auto isAppImage = 0 < appImageType && appImageType <= 2;
-
-                if (isAppImage) {
-                    // at application startup, we don't want to integrate AppImages that have been integrated already,
-                    // as that it slows down very much
-                    // the integration will be updated as soon as any of these AppImages is run with AppImageLauncher
-                    std::cout << "Found AppImage: " << path.toStdString() << std::endl;
-
-                    if (!appimage_is_registered_in_system(path.toStdString().c_str())) {
-                        std::cout << "AppImage is not integrated yet, integrating" << std::endl;
-                        worker.scheduleForIntegration(path);
-                    } else if (!desktopFileHasBeenUpdatedSinceLastUpdate(path)) {
-                        std::cout << "AppImage has been integrated already but needs to be reintegrated" << std::endl;
-                        worker.scheduleForIntegration(path);
-                    } else {
-                        std::cout << "AppImage integrated already, skipping" << std::endl;
-                    }
-                }
-            }
-        }
-    }
-}
-
 int main(int argc, char* argv[]) {
     // make sure shared won't try to use the UI
     setenv("_FORCE_HEADLESS", "1", 1);
@@ -114,6 +89,7 @@ int main(int argc, char* argv[]) {
     }
 
     QCoreApplication app(argc, argv);
+    installIconsChangedNotifier();
 
     {
         std::ostringstream version;
@@ -144,23 +120,44 @@ int main(int argc, char* argv[]) {
     // time to create the watcher object
     FileSystemWatcher watcher(watchedDirectories);
 
+    // counters describing the daemon's activity, reported via D-Bus
+    auto metrics = std::make_shared<DaemonMetrics>();
+
     // create a daemon worker instance
     // it is used to integrate all AppImages initially, and to integrate files found via inotify
-    Worker worker;
+    Worker worker(metrics);
+
+    // searches the watched directories for AppImages in the background
+    // results of previous scans allow for skipping directories and files which have not changed since
+    // the state is discarded whenever the daemon binary changes, as all AppImages might need to be reintegrated then
+    DirectoryScanner scanner(
+        ScanState::defaultPath(),
+        QCoreApplication::applicationVersion() + " " + QString::number(readFileModificationTime(argv[0]))
+    );
+
+    // AppImages are handed to the worker while the scan is still running, so integration and scanning overlap
+    // the worker integrates them after the ones it learns about through events, which the user is likely waiting for
+    QObject::connect(&scanner, &DirectoryScanner::appImageFound, &worker, &Worker::scheduleScannedForIntegration,
+                     Qt::QueuedConnection);
+
+    QObject::connect(&scanner, &DirectoryScanner::directoryScanned, &app,
+        [metrics](const QString& path, qint64 durationMs) {
+            std::cout << "Scanned directory " << path.toStdString() << " in " << durationMs << " ms" << std::endl;
+            metrics->recordScan(path, durationMs);
+        }
+    );
 
     // we we update the watched directories, the file system watcher can calculate whether there's new directories
     // to watch
     // these
-    QObject::connect(&watcher, &FileSystemWatcher::newDirectoriesToWatch, &app, [&worker](const QDirSet& newDirs) {
+    QObject::connect(&watcher, &FileSystemWatcher::newDirectoriesToWatch, &app, [&scanner](const QDirSet& newDirs) {
         if (newDirs.empty()) {
             qDebug() << "No new directories to watch detected";
         } else {
             std::cout << "Discovered new directories to watch, integrating existing AppImages initially" << std::endl;
 
-            initialSearchForAppImages(newDirs, worker);
-
-            // (re-)integrate all AppImages at once
-            worker.executeDeferredOperations();
+            // the worker integrates the AppImages found as soon as they have settled
+            scanner.scan(newDirs);
         }
     });
 
@@ -168,7 +165,7 @@ int main(int argc, char* argv[]) {
     // in this directory
     // a good example for this situation is a removable drive that has been unplugged from the computer
     QObject::connect(&watcher, &FileSystemWatcher::directoriesToWatchDisappeared, &app,
-        [](const QDirSet& disappearedDirs) {
+        [&worker](const QDirSet& disappearedDirs) {
 
         if (disappearedDirs.empty()) {
             qDebug() << "No directories disappeared";
@@ -176,47 +173,244 @@ int main(int argc, char* argv[]) {
             std::cout << "Directories to watch disappeared, unintegrating AppImages formerly found in there"
                       << std::endl;
 
-            if (!cleanUpOldDesktopIntegrationResources(true)) {
-                std::cerr << "Error: Failed to clean up old desktop integration resources" << std::endl;
-            }
+            worker.requestCleanUp();
         }
     });
 
+    // when the watcher tells us it might have missed events, we need to check the affected directories again
+    // new AppImages will be scheduled for integration, and the integration resources of removed ones cleaned up
+    // the clean up may have to walk the icons directory, so it must not block the main thread, which has to keep
+    // reading events
+    auto rescan = [&scanner, &worker](const QDirSet& dirs) {
+        scanner.scan(dirs, false);
+        worker.requestCleanUp();
+    };
+
+    QObject::connect(&watcher, &FileSystemWatcher::directoriesNeedRescan, &app, [rescan](const QDirSet& dirs) {
+        std::cout << "Events might have been lost, rescanning affected directories" << std::endl;
+        rescan(dirs);
+    });
+
+    // directories which couldn't be watched because there's too many of them are checked regularly instead
+    // thanks to the scan state, only directories which have changed since the last check need to be listed
+    QObject::connect(&watcher, &FileSystemWatcher::unwatchedDirectoriesNeedCheck, &app,
+        [&scanner](const QDirSet& dirs) {
+            qDebug() << "Checking" << dirs.size() << "unwatched directories for changes";
+            scanner.scan(dirs);
+        }
+    );
+
+    // buffers the watcher's events, so that floods of events don't overwhelm the worker
+    // events it had to drop are made up for by rescanning the affected directories
+    EventThrottle throttle;
+
+    QObject::connect(&throttle, &EventThrottle::directoriesNeedRescan, &app, [rescan](const QDirSet& dirs) {
+        std::cout << "Events have been dropped, rescanning affected directories" << std::endl;
+        rescan(dirs);
+    });
+
     // search directories to watch once initially
     // we *have* to do this even though we connect this signal above, as the first update occurs in the constructor
     // and we cannot connect signals before construction has finished for obvious reasons
-    initialSearchForAppImages(watcher.directories(), worker);
+    // the worker (re-)integrates the AppImages found as soon as they have settled
+    // afterwards, the desktop integration resources of AppImages removed while the daemon wasn't running are cleaned
+    // up on the worker's pool, as walking the applications and icons directories must not keep the main thread from
+    // reading events
+    auto initialScanFinished = std::make_shared<QMetaObject::Connection>();
+    *initialScanFinished = QObject::connect(&scanner, &DirectoryScanner::finished, &worker,
+        [&worker, initialScanFinished]() {
+            QObject::disconnect(*initialScanFinished);
+            worker.requestCleanUp();
+        },
+        Qt::QueuedConnection
+    );
 
-    // (re-)integrate all AppImages at once
-    worker.executeDeferredOperations();
+    scanner.scan(watcher.directories(), true, true);
+
+    // the directories to watch depend on the config file and on the mounted filesystems
+    // furthermore, directories which don't exist yet can't be watched, therefore we have to wait for them to be created
+    // all of these are monitored without polling
+    // the directories are recalculated entirely only when the config file changes, mounted filesystems are added and
+    // removed incrementally
+    auto* pathsWatcher = new QFileSystemWatcher(&app);
+
+    std::shared_ptr<QSettings> watchConfig;
+    QDirSet directoriesToWatch;
+    QSet<QString> followedMountPoints;
+
+    // directories to watch which don't exist yet, whose parent directories are watched instead
+    QDirSet missingDirectories;
+    bool configFileExists = false;
+
+    // watches the config file, and the parent directories of the missing directories
+    // as the set of these paths hardly ever changes, only the differences are applied
+    auto updateWatchedPaths = [&directoriesToWatch, &missingDirectories, &configFileExists, pathsWatcher]() {
+        QStringList pathsToWatch;
+
+        // when the config file is replaced (as most editors do), it's no longer watched, so it's added again below
+        // if it doesn't exist yet, we need to wait for it to be created
+        const auto configFilePath = getConfigFilePath();
+        configFileExists = QFileInfo::exists(configFilePath);
+
+        if (configFileExists) {
+            pathsToWatch << configFilePath;
+        } else {
+            pathsToWatch << QFileInfo(configFilePath).absolutePath();
+        }
+
+        missingDirectories.clear();
+
+        for (const auto& dir : directoriesToWatch) {
+            if (dir.exists())
+                continue;
+
+            missingDirectories.insert(dir);
+
+            const auto parentPath = QFileInfo(dir.absolutePath()).absolutePath();
+
+            if (QFileInfo(parentPath).isDir())
+                pathsToWatch << parentPath;
+        }
+
+        pathsToWatch.removeDuplicates();
+
+        const auto currentlyWatchedPaths = pathsWatcher->files() + pathsWatcher->directories();
+
+        QStringList pathsToUnwatch, pathsToAdd;
+
+        for (const auto& path : currentlyWatchedPaths) {
+            if (!pathsToWatch.contains(path))
+                pathsToUnwatch << path;
+        }
+
+        for (const auto& path : pathsToWatch) {
+            if (!currentlyWatchedPaths.contains(path))
+                pathsToAdd << path;
+        }
+
+        if (!pathsToUnwatch.empty())
+            pathsWatcher->removePaths(pathsToUnwatch);
+
+        if (!pathsToAdd.empty())
+            pathsWatcher->addPaths(pathsToAdd);
+    };
+
+    auto applyWatchedDirectories = [&watcher, &directoriesToWatch, &followedMountPoints, updateWatchedPaths]() {
+        watcher.followMountedFilesystems(followedMountPoints);
+        watcher.updateWatchedDirectories(directoriesToWatch);
+        updateWatchedPaths();
+    };
+
+    auto updateWatchedDirectories = [&watcher, &worker, &watchConfig, &directoriesToWatch, &followedMountPoints,
+                                     applyWatchedDirectories]() {
+        watchConfig = getConfig();
+        directoriesToWatch = daemonDirectoriesToWatch(watchConfig);
+
+        // if possible, mounted filesystems are followed with fanotify, which notices their Applications directories
+        // being created, and doesn't need any inotify watches
+        // /Applications is always watched, and following the root filesystem would be too expensive
+        followedMountPoints.clear();
+
+        if (shallMonitorMountedFilesystems(watchConfig)) {
+            for (const auto& location : additionalAppImagesLocations(true)) {
+                const auto mountPoint = QFileInfo(location).absolutePath();
+
+                if (mountPoint != "/")
+                    followedMountPoints.insert(mountPoint);
+            }
+        }
+
+        worker.setIntegrationDirectory(integratedAppImagesDestination());
+
+        applyWatchedDirectories();
+    };
+
+    // only the config file requires recalculating the directories to watch
+    // the parent directories of missing directories (e.g., $HOME for a missing ~/Applications) change frequently, so
+    // the handler merely checks whether any of the missing directories has been created
+    QObject::connect(pathsWatcher, &QFileSystemWatcher::fileChanged, &app, updateWatchedDirectories);
+    QObject::connect(pathsWatcher, &QFileSystemWatcher::directoryChanged, &app,
+        [&missingDirectories, &configFileExists, updateWatchedDirectories, applyWatchedDirectories]() {
+            if (!configFileExists && QFileInfo::exists(getConfigFilePath())) {
+                updateWatchedDirectories();
+                return;
+            }
+
+            for (const auto& dir : missingDirectories) {
+                if (dir.exists()) {
+                    applyWatchedDirectories();
+                    return;
+                }
+            }
+        }
+    );
+
+    auto* mountMonitor = new MountMonitor(&app);
+
+    // only the Applications directories (and configured directories) on the filesystems in question are added or
+    // removed, there's no need to look at the entire mount table again
+    QObject::connect(mountMonitor, &MountMonitor::mountsChanged, &app,
+        [&watchConfig, &directoriesToWatch, &followedMountPoints, applyWatchedDirectories](
+            const QList<MountMonitor::Mount>& mounted, const QList<MountMonitor::Mount>& unmounted
+        ) {
+            const auto isOnMount = [](const QDir& dir, const QString& mountPoint) {
+                const auto path = dir.absolutePath();
+                return path == mountPoint || path.startsWith(mountPoint + "/");
+            };
+
+            for (const auto& mount : unmounted) {
+                qDebug() << "Filesystem unmounted:" << mount.mountPoint;
+
+                // configured directories on the filesystem remain in the set, as they are watched again once it's
+                // mounted again, in the meantime, the watcher ignores them as they don't exist
+                if (followedMountPoints.remove(mount.mountPoint))
+                    directoriesToWatch.erase(QDir(mount.mountPoint + "/Applications"));
+            }
+
+            for (const auto& mount : mounted) {
+                qDebug() << "Filesystem mounted:" << mount.mountPoint;
+
+                if (shallMonitorMountedFilesystems(watchConfig) &&
+                    isAppImagesLocationMount(mount.device, mount.mountPoint, mount.fsType)) {
+                    followedMountPoints.insert(mount.mountPoint);
+                    directoriesToWatch.insert(QDir(mount.mountPoint + "/Applications"));
+                }
+
+                // configured directories are skipped while they don't exist, e.g., when the filesystem they're on
+                // hasn't been mounted when the config was read
+                for (const auto& dir : getAdditionalDirectoriesFromConfig(watchConfig)) {
+                    if (isOnMount(dir, mount.mountPoint))
+                        directoriesToWatch.insert(dir);
+                }
+            }
+
+            applyWatchedDirectories();
+        }
+    );
+
+    updateWatchedDirectories();
+
+    // if the mount table can't be monitored, we have to fall back to checking regularly
+    if (!mountMonitor->start()) {
+        std::cerr << "Warning: cannot monitor mount table, checking for changes regularly" << std::endl;
 
-    // we regularly want to update
-    {
         auto* timer = new QTimer(&app);
         timer->setInterval(UPDATE_WATCHED_DIRECTORIES_INTERVAL);
-        QTimer::connect(
-            timer, &QTimer::timeout, &app,[&watcher]() {
-                watcher.updateWatchedDirectories(daemonDirectoriesToWatch());
-            }
-        );
+        QTimer::connect(timer, &QTimer::timeout, &app, updateWatchedDirectories);
         timer->start();
     }
 
-    // after (re-)integrating all AppImages, clean up old desktop integration resources before start
-    if (!cleanUpOldDesktopIntegrationResources()) {
-        std::cout << "Failed to clean up old desktop integration resources" << std::endl;
-    }
-
     std::cout << "Watching directories: ";
     for (const auto& dir : watcher.directories()) {
         std::cout << dir.absolutePath().toStdString().c_str() << " ";
     }
     std::cout << std::endl;
 
-    FileSystemWatcher::connect(&watcher, &FileSystemWatcher::fileChanged, &worker, &Worker::scheduleForIntegration,
-                               Qt::QueuedConnection);
-    FileSystemWatcher::connect(&watcher, &FileSystemWatcher::fileRemoved, &worker, &Worker::scheduleForUnintegration,
-                               Qt::QueuedConnection);
+    FileSystemWatcher::connect(&watcher, &FileSystemWatcher::filesChanged, &throttle, &EventThrottle::addChangedFiles);
+    FileSystemWatcher::connect(&watcher, &FileSystemWatcher::filesRemoved, &throttle, &EventThrottle::addRemovedFiles);
+
+    QObject::connect(&throttle, &EventThrottle::fileChanged, &worker, &Worker::scheduleForIntegration);
+    QObject::connect(&throttle, &EventThrottle::fileRemoved, &worker, &Worker::scheduleForUnintegration);
 
     if (!watcher.startWatching()) {
         std::cerr << "Could not start watching directories" << std::endl;
@@ -225,6 +419,25 @@ int main(int argc, char* argv[]) {
 
     QObject::connect(&app, &QCoreApplication::aboutToQuit, &watcher, &FileSystemWatcher::stopWatching);
 
+    // the watcher is driven by the kernel's readiness notifications, so idle wakeups should never happen
+    QObject::connect(&app, &QCoreApplication::aboutToQuit, &watcher, [&watcher]() {
+        std::cout << "File system watcher woke up " << watcher.wakeups() << " times, "
+                  << watcher.idleWakeups() << " of which were idle" << std::endl;
+    });
+
+    // the control and introspection interface is optional, the daemon works fine without a session bus
+    // clients fall back to doing the work themselves if the daemon can't be reached
+    DaemonService service(&worker, &watcher, &throttle, metrics);
+
+    QObject::connect(&service, &DaemonService::rescanRequested, &app, [rescan, &watcher]() {
+        std::cout << "Rescan requested, rescanning all watched directories" << std::endl;
+        rescan(watcher.directories());
+    });
+
+    if (!service.registerOnSessionBus()) {
+        std::cerr << "Warning: control interface not available" << std::endl;
+    }
+
     auto* binaryUpdatesMonitor = setupBinaryUpdatesMonitor(argv);
     binaryUpdatesMonitor->start();
 
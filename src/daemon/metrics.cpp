@@ -0,0 +1,124 @@
+// system includes
+#include <algorithm>
+#include <array>
+
+// library includes
+#include <QMutex>
+#include <QMutexLocker>
+
+// local includes
+#include "metrics.h"
+
+// upper bounds of the histogram buckets in milliseconds, samples above the last one are only counted in the total
+static constexpr std::array<qint64, 10> HISTOGRAM_BUCKETS = {{1, 4, 16, 64, 256, 1024, 4096, 16384, 65536, 262144}};
+
+class DaemonMetrics::PrivateData {
+public:
+    struct Histogram {
+        std::array<quint64, HISTOGRAM_BUCKETS.size()> buckets{};
+        quint64 count = 0;
+        qint64 sumMs = 0;
+        qint64 maxMs = 0;
+
+        void record(qint64 durationMs) {
+            for (size_t i = 0; i < HISTOGRAM_BUCKETS.size(); ++i) {
+                if (durationMs <= HISTOGRAM_BUCKETS[i])
+                    ++buckets[i];
+            }
+
+            ++count;
+            sumMs += durationMs;
+            maxMs = std::max(maxMs, durationMs);
+        }
+    };
+
+    mutable QMutex mutex;
+
+    std::map<Stage, Histogram> latencies;
+    std::map<Result, quint64> operations;
+
+    // duration of the last scan of every directory
+    std::map<QString, qint64> scanDurations;
+
+public:
+    static QString stageName(Stage stage) {
+        switch (stage) {
+            case PROBE:
+                return "probe";
+            case REGISTER:
+                return "register";
+            case DESKTOP_FILE:
+                return "desktop_file";
+            case CACHE_REFRESH:
+                return "cache_refresh";
+        }
+
+        return "unknown";
+    }
+
+    static QString resultName(Result result) {
+        switch (result) {
+            case INTEGRATED:
+                return "integrated";
+            case UNINTEGRATED:
+                return "unintegrated";
+            case SKIPPED:
+                return "skipped";
+            case FAILED:
+                return "failed";
+        }
+
+        return "unknown";
+    }
+};
+
+DaemonMetrics::DaemonMetrics() : d(std::make_shared<PrivateData>()) {}
+
+void DaemonMetrics::recordLatency(DaemonMetrics::Stage stage, qint64 durationMs) {
+    QMutexLocker lock(&d->mutex);
+    d->latencies[stage].record(durationMs);
+}
+
+void DaemonMetrics::recordOperation(DaemonMetrics::Result result) {
+    QMutexLocker lock(&d->mutex);
+    ++d->operations[result];
+}
+
+void DaemonMetrics::recordScan(const QString& directory, qint64 durationMs) {
+    QMutexLocker lock(&d->mutex);
+    d->scanDurations[directory] = durationMs;
+}
+
+QVariantMap DaemonMetrics::toVariantMap() const {
+    QMutexLocker lock(&d->mutex);
+
+    QVariantMap map;
+
+    quint64 operationsProcessed = 0;
+
+    for (const auto& pair : d->operations) {
+        map["operations." + PrivateData::resultName(pair.first)] = pair.second;
+        operationsProcessed += pair.second;
+    }
+
+    map["operations.processed"] = operationsProcessed;
+
+    for (const auto& pair : d->latencies) {
+        const auto prefix = "latency." + PrivateData::stageName(pair.first) + ".";
+        const auto& histogram = pair.second;
+
+        map[prefix + "count"] = histogram.count;
+        map[prefix + "sum_ms"] = histogram.sumMs;
+        map[prefix + "max_ms"] = histogram.maxMs;
+
+        for (size_t i = 0; i < HISTOGRAM_BUCKETS.size(); ++i) {
+            map[prefix + "le_" + QString::number(HISTOGRAM_BUCKETS[i]) + "ms"] = histogram.buckets[i];
+        }
+    }
+
+    for (const auto& pair : d->scanDurations) {
+        map["scan.duration_ms." + pair.first] = pair.second;
+    }
+
+    return map;
+}
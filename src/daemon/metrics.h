@@ -0,0 +1,54 @@
+// system includes
+#include <map>
+#include <memory>
+#include <vector>
+
+// library includes
+#include <QString>
+#include <QVariantMap>
+
+#pragma once
+
+/**
+ * Counters describing the daemon's activity, reported by the introspection interface.
+ *
+ * All methods are thread safe, as the counters are updated from the worker's thread pool.
+ */
+class DaemonMetrics {
+public:
+    // steps of an integration whose latencies are recorded
+    enum Stage {
+        // checking whether the file is an AppImage which may be integrated
+        PROBE = 0,
+        // registration of desktop file, icons and MIME types via libappimage
+        REGISTER,
+        // AppImageLauncher specific modifications of the desktop file
+        DESKTOP_FILE,
+        // update of the desktop database and icon caches after a batch
+        CACHE_REFRESH,
+    };
+
+    enum Result {
+        INTEGRATED = 0,
+        UNINTEGRATED,
+        SKIPPED,
+        FAILED,
+    };
+
+private:
+    class PrivateData;
+    std::shared_ptr<PrivateData> d;
+
+public:
+    DaemonMetrics();
+
+    void recordLatency(Stage stage, qint64 durationMs);
+
+    void recordOperation(Result result);
+
+    void recordScan(const QString& directory, qint64 durationMs);
+
+    // returns all counters as flat key-value pairs, e.g., "latency.probe.count"
+    // histogram buckets are cumulative, i.e., "latency.probe.le_8ms" counts all samples which took at most 8 ms
+    QVariantMap toVariantMap() const;
+};
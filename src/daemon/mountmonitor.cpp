@@ -0,0 +1,179 @@
+// system includes
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <unistd.h>
+#include <vector>
+
+// library includes
+#include <QDebug>
+#include <QSocketNotifier>
+
+// local includes
+#include "mountmonitor.h"
+
+class MountMonitor::PrivateData {
+public:
+    int fd = -1;
+    QSocketNotifier* notifier = nullptr;
+
+    // mounts by mount ID
+    // IDs are unique as long as the filesystem is mounted, so they identify a mount even if another filesystem is
+    // mounted at the same location later on
+    std::map<int, Mount> mounts;
+
+public:
+    ~PrivateData() {
+        delete notifier;
+
+        if (fd >= 0)
+            close(fd);
+    }
+
+    // reads the entire mount table
+    // returns false on errors
+    bool readMounts(std::map<int, Mount>& newMounts) const {
+        // the file has to be read from the beginning every time, and it has no meaningful size
+        std::string contents;
+        std::vector<char> buffer(16 * 1024);
+
+        off_t offset = 0;
+
+        while (true) {
+            const auto rv = pread(fd, buffer.data(), buffer.size(), offset);
+
+            if (rv < 0) {
+                if (errno == EINTR)
+                    continue;
+
+                const auto error = errno;
+                std::cerr << "Failed to read mount table: " << strerror(error) << std::endl;
+                return false;
+            }
+
+            if (rv == 0)
+                break;
+
+            contents.append(buffer.data(), static_cast<size_t>(rv));
+            offset += rv;
+        }
+
+        std::istringstream iss(contents);
+
+        // format: <mount ID> <parent ID> <major:minor> <root> <mount point> <options> [<optional fields>...] -
+        //         <filesystem type> <mount source> <super options>
+        for (std::string line; std::getline(iss, line);) {
+            std::istringstream lineStream(line);
+
+            int mountId;
+            std::string parentId, majorMinor, root, mountPoint, options;
+
+            if (!(lineStream >> mountId >> parentId >> majorMinor >> root >> mountPoint >> options))
+                continue;
+
+            // the number of optional fields varies, they're terminated by a single hyphen
+            std::string field;
+
+            while (lineStream >> field && field != "-") {}
+
+            std::string fsType, source;
+            lineStream >> fsType >> source;
+
+            newMounts[mountId] = Mount{unescapeField(mountPoint), unescapeField(source), unescapeField(fsType)};
+        }
+
+        return true;
+    }
+};
+
+MountMonitor::MountMonitor(QObject* parent) : QObject(parent), d(std::make_shared<PrivateData>()) {}
+
+QString MountMonitor::unescapeField(const std::string& escaped) {
+    std::string rv;
+    rv.reserve(escaped.size());
+
+    for (size_t i = 0; i < escaped.size(); ++i) {
+        if (escaped[i] == '\\' && i + 3 < escaped.size()) {
+            const auto octal = escaped.substr(i + 1, 3);
+
+            if (octal.find_first_not_of("01234567") == std::string::npos) {
+                rv.push_back(static_cast<char>(std::stoi(octal, nullptr, 8)));
+                i += 3;
+                continue;
+            }
+        }
+
+        rv.push_back(escaped[i]);
+    }
+
+    return QString::fromStdString(rv);
+}
+
+bool MountMonitor::start() {
+    if (d->fd >= 0)
+        return true;
+
+    d->fd = open("/proc/self/mountinfo", O_RDONLY | O_CLOEXEC);
+
+    if (d->fd < 0) {
+        const auto error = errno;
+        std::cerr << "Failed to open mount table: " << strerror(error) << std::endl;
+        return false;
+    }
+
+    if (!d->readMounts(d->mounts))
+        return false;
+
+    // POLLPRI is reported as an exceptional condition
+    d->notifier = new QSocketNotifier(d->fd, QSocketNotifier::Exception);
+
+    // QSocketNotifier::activated's signature differs between Qt versions, therefore we use the string based syntax
+    connect(d->notifier, SIGNAL(activated(int)), this, SLOT(readMountTable()));
+
+    return true;
+}
+
+void MountMonitor::readMountTable() {
+    std::map<int, Mount> newMounts;
+
+    if (!d->readMounts(newMounts))
+        return;
+
+    QList<Mount> mounted, unmounted;
+
+    // both maps are sorted by ID, so the differences can be calculated in a single pass
+    auto oldIt = d->mounts.begin();
+    auto newIt = newMounts.begin();
+
+    while (oldIt != d->mounts.end() || newIt != newMounts.end()) {
+        if (newIt == newMounts.end() || (oldIt != d->mounts.end() && oldIt->first < newIt->first)) {
+            unmounted << oldIt->second;
+            ++oldIt;
+        } else if (oldIt == d->mounts.end() || newIt->first < oldIt->first) {
+            mounted << newIt->second;
+            ++newIt;
+        } else {
+            // filesystems moved with mount --move keep their ID, but appear at another mount point
+            if (oldIt->second.mountPoint != newIt->second.mountPoint) {
+                unmounted << oldIt->second;
+                mounted << newIt->second;
+            }
+
+            ++oldIt;
+            ++newIt;
+        }
+    }
+
+    d->mounts = std::move(newMounts);
+
+    // the kernel also signals changes which are not relevant to us, e.g., when mount options change
+    if (mounted.empty() && unmounted.empty()) {
+        qDebug() << "Mount table changed, but no filesystems have been mounted or unmounted";
+        return;
+    }
+
+    emit mountsChanged(mounted, unmounted);
+}
@@ -0,0 +1,50 @@
+// system includes
+#include <memory>
+#include <string>
+
+// library includes
+#include <QList>
+#include <QObject>
+#include <QString>
+
+#pragma once
+
+/**
+ * Notifies about filesystems being mounted or unmounted.
+ *
+ * The kernel signals changes of the mount table by flagging /proc/self/mountinfo with an exceptional condition
+ * (POLLPRI), so the monitor only ever wakes up when something has changed. The table is then compared to the previous
+ * one by the mounts' IDs.
+ */
+class MountMonitor : public QObject {
+    Q_OBJECT
+
+public:
+    struct Mount {
+        QString mountPoint;
+        // mount source, i.e., the device for most filesystems
+        QString device;
+        QString fsType;
+    };
+
+private:
+    class PrivateData;
+    std::shared_ptr<PrivateData> d;
+
+public:
+    explicit MountMonitor(QObject* parent = nullptr);
+
+    // reads the current mount table and starts monitoring it
+    // returns false if the mount table can't be monitored
+    bool start();
+
+    // mountinfo escapes spaces, tabs, newlines and backslashes in its fields as octal sequences (e.g., \040)
+    static QString unescapeField(const std::string& escaped);
+
+private slots:
+    void readMountTable();
+
+signals:
+    // emitted with the filesystems which have been mounted and unmounted since the last change
+    void mountsChanged(QList<MountMonitor::Mount> mounted, QList<MountMonitor::Mount> unmounted);
+};
@@ -0,0 +1,153 @@
+// system includes
+#include <iostream>
+
+// library includes
+#include <QDataStream>
+#include <QDebug>
+#include <QSaveFile>
+
+// local includes
+#include "operationjournal.h"
+#include "shared.h"
+
+// identifies the file format, must be changed whenever the format changes
+static const quint32 JOURNAL_MAGIC = 0x41494c4a;
+static const quint32 JOURNAL_VERSION = 1;
+
+// kinds of records
+static const quint8 RECORD_SCHEDULED = 0;
+static const quint8 RECORD_COMPLETED = 1;
+
+// the journal is compacted once it contains at least this many records which are no longer needed
+static const int COMPACTION_THRESHOLD = 1024;
+
+OperationJournal::OperationJournal(QString path) : path(std::move(path)) {}
+
+QString OperationJournal::defaultPath() {
+    return pathToCacheDirectory() + "/operations.journal";
+}
+
+std::deque<Operation> OperationJournal::replay() {
+    pendingOperations = PendingOperations();
+
+    QFile journalFile(path);
+
+    if (journalFile.open(QIODevice::ReadOnly)) {
+        QDataStream stream(&journalFile);
+
+        quint32 magic = 0, version = 0;
+        stream >> magic >> version;
+
+        if (magic != JOURNAL_MAGIC || version != JOURNAL_VERSION) {
+            std::cerr << "Warning: ignoring operation journal with unknown format" << std::endl;
+        } else {
+            while (!stream.atEnd()) {
+                quint8 kind = 0, type = 0;
+                QString operationPath;
+
+                stream >> kind >> operationPath >> type;
+
+                // the last record might be incomplete if the daemon was killed while writing it
+                if (stream.status() != QDataStream::Ok) {
+                    std::cerr << "Warning: operation journal ends with an incomplete record, ignoring it" << std::endl;
+                    break;
+                }
+
+                if (kind == RECORD_SCHEDULED) {
+                    // the operation is moved to the end of the queue, like when it was scheduled originally
+                    pendingOperations.remove(operationPath);
+                    pendingOperations.schedule(operationPath, static_cast<OP_TYPE>(type));
+                } else if (kind == RECORD_COMPLETED) {
+                    pendingOperations.remove(operationPath);
+                }
+            }
+        }
+    } else {
+        qDebug() << "No operation journal found at" << path;
+    }
+
+    // start over with a file containing only the operations that are still pending
+    if (!compact())
+        std::cerr << "Warning: failed to compact operation journal" << std::endl;
+
+    return pendingOperations.operations();
+}
+
+void OperationJournal::recordScheduled(const Operation& operation) {
+    pendingOperations.remove(operation.first);
+    pendingOperations.schedule(operation.first, operation.second);
+
+    if (!appendRecord(RECORD_SCHEDULED, operation.first, operation.second))
+        std::cerr << "Warning: failed to write to operation journal" << std::endl;
+}
+
+void OperationJournal::recordCompleted(const QString& operationPath) {
+    pendingOperations.remove(operationPath);
+
+    if (!appendRecord(RECORD_COMPLETED, operationPath, INTEGRATE))
+        std::cerr << "Warning: failed to write to operation journal" << std::endl;
+}
+
+void OperationJournal::compactIfNecessary() {
+    const auto obsoleteRecordsCount = recordsCount - pendingOperations.size();
+
+    // once all operations have been completed, the journal can be emptied cheaply
+    if (obsoleteRecordsCount < COMPACTION_THRESHOLD && !(pendingOperations.empty() && recordsCount > 0))
+        return;
+
+    qDebug() << "Compacting operation journal," << obsoleteRecordsCount << "records are no longer needed";
+
+    if (!compact())
+        std::cerr << "Warning: failed to compact operation journal" << std::endl;
+}
+
+bool OperationJournal::appendRecord(quint8 kind, const QString& operationPath, OP_TYPE type) {
+    if (!file.isOpen())
+        return false;
+
+    QDataStream stream(&file);
+    stream << kind << operationPath << static_cast<quint8>(type);
+
+    ++recordsCount;
+
+    // the record must be handed to the kernel right away, so that it survives the daemon being killed or restarting
+    // itself via execv()
+    return stream.status() == QDataStream::Ok && file.flush();
+}
+
+bool OperationJournal::compact() {
+    if (file.isOpen())
+        file.close();
+
+    recordsCount = 0;
+
+    const auto operations = pendingOperations.operations();
+
+    {
+        // the journal is replaced atomically, so a crash while compacting doesn't lose the old one
+        QSaveFile saveFile(path);
+
+        if (!saveFile.open(QIODevice::WriteOnly))
+            return false;
+
+        QDataStream stream(&saveFile);
+        stream << JOURNAL_MAGIC << JOURNAL_VERSION;
+
+        for (const auto& operation : operations) {
+            stream << RECORD_SCHEDULED << operation.first << static_cast<quint8>(operation.second);
+        }
+
+        if (stream.status() != QDataStream::Ok) {
+            saveFile.cancelWriting();
+            return false;
+        }
+
+        if (!saveFile.commit())
+            return false;
+    }
+
+    recordsCount = static_cast<int>(operations.size());
+
+    file.setFileName(path);
+    return file.open(QIODevice::WriteOnly | QIODevice::Append);
+}
@@ -0,0 +1,55 @@
+// system includes
+#include <deque>
+
+// library includes
+#include <QFile>
+#include <QString>
+
+// local includes
+#include "pendingoperations.h"
+
+#pragma once
+
+/**
+ * Append-only journal of the worker's pending operations.
+ *
+ * Every operation is recorded when it's scheduled, and again when it has been executed. After a crash or restart, the
+ * journal is replayed, so that only the operations which were still pending or in flight need to be executed again.
+ *
+ * The last record of a path determines its state, therefore an operation scheduled again while it's being executed is
+ * not lost when the completion of the running one is recorded.
+ *
+ * The journal is compacted regularly by rewriting it with the pending operations only. A truncated record at the end
+ * (e.g., when the daemon was killed while writing it) is discarded when replaying the journal.
+ */
+class OperationJournal {
+private:
+    QString path;
+    QFile file;
+
+    // operations which have been scheduled but not completed yet, i.e., what the journal would replay
+    PendingOperations pendingOperations;
+
+    // number of records in the file, used to decide when to compact it
+    int recordsCount = 0;
+
+public:
+    explicit OperationJournal(QString path);
+
+    // default location in the cache directory
+    static QString defaultPath();
+
+    // reads the journal, and returns the operations which have not been completed, in the order they were scheduled
+    // afterwards, the journal is compacted and opened for appending
+    std::deque<Operation> replay();
+
+    void recordScheduled(const Operation& operation);
+    void recordCompleted(const QString& path);
+
+    // rewrites the journal if it consists mostly of records which are no longer needed
+    void compactIfNecessary();
+
+private:
+    bool appendRecord(quint8 kind, const QString& path, OP_TYPE type);
+    bool compact();
+};
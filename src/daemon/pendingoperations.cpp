@@ -0,0 +1,103 @@
+// local includes
+#include "pendingoperations.h"
+
+PendingOperations::ScheduleResult PendingOperations::schedule(const QString& path, OP_TYPE type,
+                                                              OP_PRIORITY priority, quint64 cost) {
+    // the order of the other classes must not depend on the cost
+    if (priority != PRIORITY_BULK)
+        cost = 0;
+
+    auto it = entries.find(path);
+
+    if (it == entries.end()) {
+        const Key key{priority, cost, nextSequenceNumber++};
+
+        entries.insert(path, Entry{type, key});
+        order.emplace(key, path);
+
+        return ADDED;
+    }
+
+    if (it->type == type) {
+        // e.g., a file found by a scan has been modified by the user in the meantime
+        if (priority < it->key.priority) {
+            order.erase(it->key);
+
+            it->key.priority = priority;
+            it->key.cost = cost;
+            order.emplace(it->key, path);
+        }
+
+        return MERGED;
+    }
+
+    // the other operation supersedes the pending one, and is moved to the end of the queue
+    order.erase(it->key);
+
+    it->type = type;
+    it->key = Key{priority, cost, nextSequenceNumber++};
+    order.emplace(it->key, path);
+
+    return REPLACED;
+}
+
+bool PendingOperations::empty() const {
+    return entries.empty();
+}
+
+bool PendingOperations::contains(const QString& path) const {
+    return entries.contains(path);
+}
+
+void PendingOperations::remove(const QString& path) {
+    const auto it = entries.find(path);
+
+    if (it == entries.end())
+        return;
+
+    order.erase(it->key);
+    entries.erase(it);
+}
+
+std::deque<Operation> PendingOperations::operations() const {
+    std::deque<Operation> operations;
+
+    for (const auto& pair : order) {
+        operations.emplace_back(pair.second, entries.value(pair.second).type);
+    }
+
+    return operations;
+}
+
+bool PendingOperations::containsPriority(OP_PRIORITY priority) const {
+    return !order.empty() && order.begin()->first.priority <= priority;
+}
+
+int PendingOperations::size() const {
+    return entries.size();
+}
+
+std::deque<PrioritizedOperation> PendingOperations::takeIf(const std::function<bool(const Operation&)>& isReady,
+                                                           OP_PRIORITY lowestPriority) {
+    std::deque<PrioritizedOperation> operations;
+
+    auto it = order.begin();
+    while (it != order.end() && it->first.priority <= lowestPriority) {
+        const auto& path = it->second;
+        const auto entry = entries.find(path);
+
+        const Operation operation{path, entry->type};
+
+        if (!isReady(operation)) {
+            ++it;
+            continue;
+        }
+
+        operations.emplace_back(operation, it->first.priority);
+
+        entries.erase(entry);
+        it = order.erase(it);
+    }
+
+    return operations;
+}
@@ -0,0 +1,108 @@
+// system includes
+#include <deque>
+#include <functional>
+#include <map>
+#include <tuple>
+
+// library includes
+#include <QHash>
+#include <QString>
+
+#pragma once
+
+enum OP_TYPE {
+    INTEGRATE = 0,
+    UNINTEGRATE = 1,
+    // unintegrates the file even if it still exists, used for explicit requests by clients
+    FORCE_UNINTEGRATE = 2,
+};
+
+typedef std::pair<QString, OP_TYPE> Operation;
+
+// operations of a lower priority class are only executed when no operations of higher ones are ready
+enum OP_PRIORITY {
+    // requested by clients, or caused by recent file system events, i.e., the user is likely waiting for the result
+    PRIORITY_INTERACTIVE = 0,
+    // found by scanning the main integration directory
+    PRIORITY_MAIN_DIRECTORY = 1,
+    // found by scanning additional directories or mounted filesystems, which may contain lots of AppImages
+    PRIORITY_BULK = 2,
+};
+
+typedef std::pair<Operation, OP_PRIORITY> PrioritizedOperation;
+
+/**
+ * Table of pending operations, indexed by path.
+ *
+ * There is at most one pending operation per path. Repeated operations of the same type are merged into the pending
+ * one, which keeps its position in the queue. An operation of another type cancels the pending one, and is queued at
+ * the end instead (e.g., when a file is removed before it could be integrated, it only needs to be
+ * unintegrated).
+ *
+ * The queue is ordered by priority class first. Within the bulk class, cheaper operations come first, so that as many
+ * AppImages as possible show up in the menu quickly. The other classes are processed in arrival order.
+ * Merging an operation of a higher priority class into a pending one moves the pending one up.
+ */
+class PendingOperations {
+public:
+    enum ScheduleResult {
+        // no operation has been pending for the path
+        ADDED = 0,
+        // an operation of the same type has been pending already
+        MERGED,
+        // an operation of another type has been pending, and has been cancelled
+        REPLACED,
+    };
+
+private:
+    // position of an operation in the queue
+    struct Key {
+        OP_PRIORITY priority;
+        quint64 cost;
+        quint64 sequenceNumber;
+
+        bool operator<(const Key& other) const {
+            return std::tie(priority, cost, sequenceNumber) <
+                   std::tie(other.priority, other.cost, other.sequenceNumber);
+        }
+    };
+
+    struct Entry {
+        OP_TYPE type;
+        Key key;
+    };
+
+    QHash<QString, Entry> entries;
+
+    // keeps the order in which the operations are going to be executed
+    std::map<Key, QString> order;
+
+    quint64 nextSequenceNumber = 0;
+
+public:
+    // cost is an estimate of the effort required to execute the operation, and only considered in the bulk class
+    ScheduleResult schedule(const QString& path, OP_TYPE type, OP_PRIORITY priority = PRIORITY_INTERACTIVE,
+                            quint64 cost = 0);
+
+    bool empty() const;
+
+    // checks whether an operation is pending for the given path
+    bool contains(const QString& path) const;
+
+    // removes the pending operation for the given path, if any
+    void remove(const QString& path);
+
+    // returns all pending operations in queue order, without removing them
+    std::deque<Operation> operations() const;
+
+    // checks whether an operation of at least the given priority class is pending
+    bool containsPriority(OP_PRIORITY priority) const;
+
+    // current queue depth
+    int size() const;
+
+    // removes all operations of at least the given priority class for which isReady returns true from the table, and
+    // returns them in queue order
+    std::deque<PrioritizedOperation> takeIf(const std::function<bool(const Operation&)>& isReady,
+                                            OP_PRIORITY lowestPriority = PRIORITY_BULK);
+};
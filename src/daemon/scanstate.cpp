@@ -0,0 +1,162 @@
+// system includes
+#include <iostream>
+
+// library includes
+#include <QDataStream>
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+
+// local includes
+#include "scanstate.h"
+#include "shared.h"
+
+// identifies the file format, must be changed whenever the format changes
+static const quint32 SCAN_STATE_MAGIC = 0x41494c53;
+static const quint32 SCAN_STATE_VERSION = 2;
+
+ScanState::ScanState(QString path, QString stamp) : path(std::move(path)), stamp(std::move(stamp)) {}
+
+QString ScanState::defaultPath() {
+    return pathToCacheDirectory() + "/scan-state";
+}
+
+void ScanState::load() {
+    directories.clear();
+
+    QFile file(path);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "No scan state found at" << path;
+        return;
+    }
+
+    QDataStream stream(&file);
+
+    quint32 magic = 0, version = 0;
+    QString storedStamp;
+
+    stream >> magic >> version;
+
+    if (magic != SCAN_STATE_MAGIC || version != SCAN_STATE_VERSION) {
+        std::cerr << "Warning: ignoring scan state with unknown format" << std::endl;
+        return;
+    }
+
+    stream >> storedStamp;
+
+    if (storedStamp != stamp) {
+        std::cout << "Scan state has been created by a different version, ignoring" << std::endl;
+        return;
+    }
+
+    quint32 directoriesCount = 0;
+    stream >> directoriesCount;
+
+    for (quint32 i = 0; i < directoriesCount && stream.status() == QDataStream::Ok; ++i) {
+        QString dirPath;
+        Directory directory;
+        quint32 entriesCount = 0;
+
+        stream >> dirPath >> directory.mtimeNs >> entriesCount;
+
+        for (quint32 j = 0; j < entriesCount && stream.status() == QDataStream::Ok; ++j) {
+            QString fileName;
+            Entry entry{};
+
+            stream >> fileName >> entry.inode >> entry.size >> entry.mtimeNs >> entry.type;
+
+            directory.entries.emplace(fileName, entry);
+        }
+
+        quint32 subdirectoriesCount = 0;
+        stream >> subdirectoriesCount;
+
+        for (quint32 j = 0; j < subdirectoriesCount && stream.status() == QDataStream::Ok; ++j) {
+            QString subdirectoryName;
+            stream >> subdirectoryName;
+
+            directory.subdirectories.insert(subdirectoryName);
+        }
+
+        directories.emplace(dirPath, std::move(directory));
+    }
+
+    // a truncated or otherwise broken file must not be used, we'd otherwise skip files which have never been checked
+    if (stream.status() != QDataStream::Ok) {
+        std::cerr << "Warning: scan state is corrupt, ignoring" << std::endl;
+        directories.clear();
+    }
+}
+
+bool ScanState::save() const {
+    QSaveFile file(path);
+
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QDataStream stream(&file);
+
+    stream << SCAN_STATE_MAGIC << SCAN_STATE_VERSION << stamp;
+    stream << static_cast<quint32>(directories.size());
+
+    for (const auto& dirPair : directories) {
+        const auto& directory = dirPair.second;
+
+        stream << dirPair.first << directory.mtimeNs << static_cast<quint32>(directory.entries.size());
+
+        for (const auto& entryPair : directory.entries) {
+            const auto& entry = entryPair.second;
+            stream << entryPair.first << entry.inode << entry.size << entry.mtimeNs << entry.type;
+        }
+
+        stream << static_cast<quint32>(directory.subdirectories.size());
+
+        for (const auto& subdirectoryName : directory.subdirectories) {
+            stream << subdirectoryName;
+        }
+    }
+
+    if (stream.status() != QDataStream::Ok) {
+        file.cancelWriting();
+        return false;
+    }
+
+    return file.commit();
+}
+
+const ScanState::Directory* ScanState::directory(const QString& dirPath) const {
+    const auto it = directories.find(dirPath);
+
+    if (it == directories.end())
+        return nullptr;
+
+    return &(it->second);
+}
+
+void ScanState::setDirectory(const QString& dirPath, ScanState::Directory state) {
+    directories[dirPath] = std::move(state);
+}
+
+void ScanState::pruneDirectories(const std::set<QString>& roots, const std::set<QString>& reachedDirectories,
+                                 bool allRoots) {
+    auto isWithinRoots = [&roots](const QString& dirPath) {
+        for (const auto& root : roots) {
+            if (dirPath == root || dirPath.startsWith(root + "/"))
+                return true;
+        }
+
+        return false;
+    };
+
+    auto it = directories.begin();
+
+    while (it != directories.end()) {
+        if (reachedDirectories.find(it->first) == reachedDirectories.end() && (allRoots || isWithinRoots(it->first))) {
+            it = directories.erase(it);
+            continue;
+        }
+
+        ++it;
+    }
+}
@@ -0,0 +1,71 @@
+// system includes
+#include <map>
+#include <set>
+
+// library includes
+#include <QString>
+
+#pragma once
+
+/**
+ * Persistent record of the results of previous directory scans.
+ *
+ * For every scanned directory, its modification time, the names of its subdirectories, and the stat data and AppImage
+ * type of every file in there are stored. On the next scan, directories whose modification time has not changed can be
+ * skipped entirely, and only files whose stat data changed need to be inspected again.
+ *
+ * The state is bound to a stamp (e.g., the daemon's version), and discarded when the stamp changes.
+ */
+class ScanState {
+public:
+    struct Entry {
+        quint64 inode;
+        qint64 size;
+        qint64 mtimeNs;
+        // AppImage type as returned by appimage_get_type(...)
+        qint32 type;
+
+        bool isSameFileAs(const Entry& other) const {
+            return inode == other.inode && size == other.size && mtimeNs == other.mtimeNs;
+        }
+    };
+
+    struct Directory {
+        qint64 mtimeNs = -1;
+        // keyed by filename
+        std::map<QString, Entry> entries;
+        // names of the subdirectories, which need to be scanned even if this directory hasn't changed
+        std::set<QString> subdirectories;
+    };
+
+private:
+    const QString path;
+    const QString stamp;
+
+    std::map<QString, Directory> directories;
+
+public:
+    ScanState(QString path, QString stamp);
+
+public:
+    // default location of the state file within the cache directory
+    static QString defaultPath();
+
+    // loads the state from disk
+    // if the file doesn't exist, is invalid or has been created with a different stamp, the state remains empty
+    void load();
+
+    // writes the state to disk atomically
+    bool save() const;
+
+    // returns the state of the given directory, or nullptr if it has not been scanned before
+    const Directory* directory(const QString& dirPath) const;
+
+    void setDirectory(const QString& dirPath, Directory state);
+
+    // drops the state of the directories within the given roots (including the roots themselves) which have not been
+    // reached by a scan of these roots, e.g., because they have been removed
+    // if allRoots is set, the roots are all directories which are scanned, and the state of directories outside them
+    // is dropped, too
+    void pruneDirectories(const std::set<QString>& roots, const std::set<QString>& reachedDirectories, bool allRoots);
+};
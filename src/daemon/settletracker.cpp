@@ -0,0 +1,130 @@
+// system includes
+#include <algorithm>
+#include <sys/stat.h>
+#include <vector>
+
+// local includes
+#include "settletracker.h"
+
+// the check intervals must never be 0, otherwise files which keep changing would be checked in a busy loop
+static constexpr qint64 MIN_CHECK_INTERVAL = 100;
+
+SettleTracker::SettleTracker(qint64 settleTime, qint64 maxInterval)
+    : settleTime(std::max(settleTime, MIN_CHECK_INTERVAL)),
+      maxInterval(std::max(this->settleTime, maxInterval)) {
+    clock.start();
+}
+
+void SettleTracker::readStat(const QString& path, SettleTracker::Entry& entry) {
+    struct stat st{};
+
+    entry.exists = stat(path.toStdString().c_str(), &st) == 0;
+
+    if (entry.exists) {
+        entry.size = st.st_size;
+        entry.mtimeNs = st.st_mtim.tv_sec * 1000000000ll + st.st_mtim.tv_nsec;
+    } else {
+        entry.size = -1;
+        entry.mtimeNs = -1;
+    }
+}
+
+void SettleTracker::setNextCheck(const QString& path, SettleTracker::Entry& entry, qint64 nextCheck) {
+    checkOrder.erase(std::make_pair(entry.nextCheck, path));
+
+    entry.nextCheck = nextCheck;
+    checkOrder.emplace(nextCheck, path);
+}
+
+void SettleTracker::track(const QString& path) {
+    const auto now = clock.elapsed();
+
+    auto it = entries.find(path);
+
+    if (it == entries.end()) {
+        Entry entry{};
+        readStat(path, entry);
+        entry.interval = settleTime;
+        entry.nextCheck = now + entry.interval;
+
+        entries.emplace(path, entry);
+        checkOrder.emplace(entry.nextCheck, path);
+        return;
+    }
+
+    // the file has changed again, therefore the settle time starts over
+    // the current interval is kept, as files which changed before are likely to change again
+    auto& entry = it->second;
+    readStat(path, entry);
+    setNextCheck(path, entry, now + entry.interval);
+}
+
+void SettleTracker::forget(const QString& path) {
+    const auto it = entries.find(path);
+
+    if (it == entries.end())
+        return;
+
+    checkOrder.erase(std::make_pair(it->second.nextCheck, path));
+    entries.erase(it);
+}
+
+bool SettleTracker::isTracked(const QString& path) const {
+    return entries.find(path) != entries.end();
+}
+
+bool SettleTracker::empty() const {
+    return entries.empty();
+}
+
+QStringList SettleTracker::checkSettled() {
+    QStringList settledPaths;
+
+    const auto now = clock.elapsed();
+
+    // files whose check is due within this time are checked as well, which helps batching operations
+    const auto slack = settleTime / 4;
+
+    // the files which are checked are taken out of the order first, as checking them changes their position in it
+    std::vector<QString> duePaths;
+
+    for (auto it = checkOrder.begin(); it != checkOrder.end() && it->first <= now + slack;) {
+        duePaths.push_back(it->second);
+        it = checkOrder.erase(it);
+    }
+
+    for (const auto& path : duePaths) {
+        const auto it = entries.find(path);
+        auto& entry = it->second;
+
+        Entry current{};
+        readStat(path, current);
+
+        // files that disappeared are reported as settled, too, so that their operations don't wait forever
+        if (!current.exists || (entry.exists && current.size == entry.size && current.mtimeNs == entry.mtimeNs)) {
+            settledPaths << path;
+            entries.erase(it);
+            continue;
+        }
+
+        // the file is still changing, therefore we back off
+        entry.exists = current.exists;
+        entry.size = current.size;
+        entry.mtimeNs = current.mtimeNs;
+        entry.interval = std::min(entry.interval * 2, maxInterval);
+        entry.nextCheck = now + entry.interval;
+
+        checkOrder.emplace(entry.nextCheck, path);
+    }
+
+    return settledPaths;
+}
+
+qint64 SettleTracker::msUntilNextCheck() const {
+    if (checkOrder.empty())
+        return -1;
+
+    const auto now = clock.elapsed();
+
+    return std::max(checkOrder.begin()->first - now, static_cast<qint64>(0));
+}
@@ -0,0 +1,67 @@
+// system includes
+#include <map>
+#include <set>
+#include <utility>
+
+// library includes
+#include <QElapsedTimer>
+#include <QString>
+#include <QStringList>
+
+#pragma once
+
+/**
+ * Tracks files which are possibly still being written to, and tells when they have settled, i.e., when their size and
+ * modification time have not changed for a given amount of time.
+ *
+ * Files which keep changing are checked less and less frequently (exponential back-off), as e.g., large downloads
+ * may take a while to finish.
+ */
+class SettleTracker {
+private:
+    struct Entry {
+        bool exists;
+        qint64 size;
+        qint64 mtimeNs;
+
+        // current check interval, grows while the file keeps changing
+        qint64 interval;
+        // time of next check, relative to the tracker's clock
+        qint64 nextCheck;
+    };
+
+    const qint64 settleTime;
+    const qint64 maxInterval;
+
+    QElapsedTimer clock;
+    std::map<QString, Entry> entries;
+
+    // the tracked files ordered by their next check, so that the due ones can be found without looking at all files
+    std::set<std::pair<qint64, QString>> checkOrder;
+
+    static void readStat(const QString& path, Entry& entry);
+
+    void setNextCheck(const QString& path, Entry& entry, qint64 nextCheck);
+
+public:
+    // times are in milliseconds, the settle time is raised to at least 100 ms
+    SettleTracker(qint64 settleTime, qint64 maxInterval);
+
+public:
+    // starts tracking a file, or notes that an already tracked file has changed again
+    void track(const QString& path);
+
+    // stops tracking a file
+    void forget(const QString& path);
+
+    bool isTracked(const QString& path) const;
+
+    bool empty() const;
+
+    // checks all files that are due, and returns (and stops tracking) the ones which have settled
+    // files which are almost due are checked as well, so that files which arrived together are returned together
+    QStringList checkSettled();
+
+    // milliseconds until the next check is due, or -1 if no files are tracked
+    qint64 msUntilNextCheck() const;
+};
@@ -0,0 +1,114 @@
+// system includes
+#include <ctime>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+// library includes
+#include <QDebug>
+#include <QDir>
+#include <QEventLoop>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+#include <QTimer>
+
+// local includes
+#include "directoryscanner.h"
+#include "registereddesktopfiles.h"
+
+class DirectoryScannerTest : public QObject {
+    Q_OBJECT
+
+private:
+    QTemporaryDir tempDir;
+
+    QString appImagesDirPath() const {
+        return tempDir.path() + "/Applications";
+    }
+
+    QString appImagePath() const {
+        return appImagesDirPath() + "/test.AppImage";
+    }
+
+    // writes a file which libappimage considers a type 2 AppImage
+    static void writeAppImage(const QString& path, char payload) {
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+
+        QByteArray header("\x7f" "ELF\x02\x01\x01\x00" "AI\x02", 11);
+        header.append(QByteArray(64, payload));
+
+        QCOMPARE(file.write(header), qint64(header.size()));
+    }
+
+    static void setMTime(const QString& path, time_t seconds) {
+        const struct timespec times[2] = {{seconds, 0}, {seconds, 0}};
+        QCOMPARE(utimensat(AT_FDCWD, path.toStdString().c_str(), times, 0), 0);
+    }
+
+    // scans the AppImages directory, and returns the AppImages reported to need an integration
+    QStringList scan(bool skipUnchangedDirectories) {
+        DirectoryScanner scanner(tempDir.path() + "/scan-state", "test");
+
+        QStringList found;
+        QEventLoop loop;
+
+        // the signals are emitted on the scanner's threads
+        connect(&scanner, &DirectoryScanner::appImageFound, &loop, [&found](const QString& path, qint64) {
+            found << path;
+        }, Qt::QueuedConnection);
+        connect(&scanner, &DirectoryScanner::finished, &loop, &QEventLoop::quit, Qt::QueuedConnection);
+
+        QTimer::singleShot(10000, &loop, [&loop]() { loop.exit(1); });
+
+        scanner.scan({QDir(appImagesDirPath())}, skipUnchangedDirectories);
+
+        if (loop.exec() != 0)
+            qWarning() << "Timed out waiting for the scan";
+
+        return found;
+    }
+
+private slots:
+    void initTestCase() {
+        QVERIFY(tempDir.isValid());
+
+        // the registered desktop files are looked up in $XDG_DATA_HOME/applications
+        qputenv("XDG_DATA_HOME", QFile::encodeName(tempDir.path() + "/share"));
+        qputenv("XDG_CACHE_HOME", QFile::encodeName(tempDir.path() + "/cache"));
+
+        QVERIFY(QDir().mkpath(appImagesDirPath()));
+        QVERIFY(QDir().mkpath(tempDir.path() + "/share/applications"));
+    }
+
+    void reintegratesAppImagesModifiedInPlace() {
+        writeAppImage(appImagePath(), 'a');
+
+        // register the AppImage like an integration would, with a desktop file which is newer than the test binary
+        const auto desktopFilePath = tempDir.path() + "/share/applications/appimagekit_" +
+                                     RegisteredDesktopFiles::pathDigest(appImagePath()) + "-test.desktop";
+        {
+            QFile desktopFile(desktopFilePath);
+            QVERIFY(desktopFile.open(QIODevice::WriteOnly));
+            desktopFile.write("[Desktop Entry]\nType=Application\nName=Test\n");
+        }
+        setMTime(desktopFilePath, time(nullptr) + 3600);
+
+        // integrated AppImages seen for the first time are skipped
+        QCOMPARE(scan(true), QStringList());
+
+        // update the AppImage in place without changing its size, as if the events reporting it had been lost
+        writeAppImage(appImagePath(), 'b');
+        setMTime(appImagePath(), time(nullptr) - 60);
+
+        // the desktop file is still newer than the binary, yet the AppImage must be reintegrated
+        QCOMPARE(scan(false), QStringList{appImagePath()});
+
+        // once it has been seen, it is skipped again
+        QCOMPARE(scan(false), QStringList());
+    }
+};
+
+QTEST_GUILESS_MAIN(DirectoryScannerTest)
+
+#include "test_directoryscanner.moc"
@@ -0,0 +1,84 @@
+// library includes
+#include <QTest>
+
+// local includes
+#include "eventthrottle.h"
+
+class EventThrottleTest : public QObject {
+    Q_OBJECT
+
+private:
+    // collects the throttle's output
+    struct Output {
+        QStringList changed;
+        QStringList removed;
+        QList<QDirSet> rescans;
+
+        explicit Output(EventThrottle& throttle) {
+            QObject::connect(&throttle, &EventThrottle::fileChanged, [this](const QString& path) {
+                changed << path;
+            });
+            QObject::connect(&throttle, &EventThrottle::fileRemoved, [this](const QString& path) {
+                removed << path;
+            });
+            QObject::connect(&throttle, &EventThrottle::directoriesNeedRescan, [this](const QDirSet& set) {
+                rescans << set;
+            });
+        }
+    };
+
+private slots:
+    void coalescesAndForwardsEvents() {
+        EventThrottle throttle(16, 500);
+        Output output(throttle);
+
+        throttle.addChangedFiles({"/dir/a", "/dir/a", "/dir/b", "/dir/c"});
+        throttle.addRemovedFiles({"/dir/c"});
+
+        QCOMPARE(throttle.eventsReceived(), quint64(5));
+        QCOMPARE(throttle.eventsCoalesced(), quint64(2));
+        QCOMPARE(throttle.bufferedEvents(), 3);
+
+        QTRY_COMPARE(throttle.bufferedEvents(), 0);
+
+        // events are forwarded in arrival order, and a removal supersedes a pending change
+        QCOMPARE(output.changed, (QStringList{"/dir/a", "/dir/b"}));
+        QCOMPARE(output.removed, QStringList{"/dir/c"});
+        QCOMPARE(throttle.eventsForwarded(), quint64(3));
+        QCOMPARE(throttle.eventsDropped(), quint64(0));
+    }
+
+    void dropsEventsBeyondCapacityAndRescans() {
+        EventThrottle throttle(2, 500);
+        Output output(throttle);
+
+        throttle.addChangedFiles({"/full/a", "/full/b", "/dirty/c"});
+
+        QCOMPARE(throttle.bufferedEvents(), 2);
+        QCOMPARE(throttle.eventsDropped(), quint64(1));
+
+        // further events for buffered paths are still coalesced, the ones of dirty directories are dropped
+        throttle.addChangedFiles({"/full/a", "/dirty/d"});
+
+        QCOMPARE(throttle.eventsCoalesced(), quint64(1));
+        QCOMPARE(throttle.eventsDropped(), quint64(2));
+
+        QTRY_COMPARE(output.changed, (QStringList{"/full/a", "/full/b"}));
+        QVERIFY(output.rescans.empty());
+
+        // once no events have been dropped for a while, the dirty directories are rescanned
+        QTRY_COMPARE_WITH_TIMEOUT(output.rescans.size(), 1, 5000);
+        QCOMPARE(output.rescans.front().size(), size_t(1));
+        QCOMPARE(output.rescans.front().begin()->absolutePath(), QString("/dirty"));
+        QCOMPARE(throttle.rescansRequested(), quint64(1));
+
+        // afterwards, events are accepted again
+        throttle.addChangedFiles({"/dirty/e"});
+        QTRY_COMPARE(output.changed.size(), 3);
+        QCOMPARE(throttle.eventsDropped(), quint64(2));
+    }
+};
+
+QTEST_GUILESS_MAIN(EventThrottleTest)
+
+#include "test_eventthrottle.moc"
@@ -0,0 +1,39 @@
+// library includes
+#include <QTest>
+
+// local includes
+#include "mountmonitor.h"
+
+class MountMonitorTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void unescapeField_data() {
+        QTest::addColumn<QByteArray>("escaped");
+        QTest::addColumn<QString>("expected");
+
+        QTest::newRow("plain") << QByteArray("/media/user/disk") << QString("/media/user/disk");
+        QTest::newRow("space") << QByteArray("/media/user/My\\040Disk") << QString("/media/user/My Disk");
+        QTest::newRow("tab") << QByteArray("/mnt/a\\011b") << QString("/mnt/a\tb");
+        QTest::newRow("newline") << QByteArray("/mnt/a\\012b") << QString("/mnt/a\nb");
+        QTest::newRow("backslash") << QByteArray("/mnt/a\\134b") << QString("/mnt/a\\b");
+        QTest::newRow("at end") << QByteArray("/mnt/disk\\040") << QString("/mnt/disk ");
+        QTest::newRow("consecutive") << QByteArray("/mnt/\\040\\040") << QString("/mnt/  ");
+        // sequences which aren't octal, or are incomplete, are kept as they are
+        QTest::newRow("not octal") << QByteArray("/mnt/a\\09b") << QString("/mnt/a\\09b");
+        QTest::newRow("incomplete") << QByteArray("/mnt/a\\04") << QString("/mnt/a\\04");
+        // non-ASCII characters aren't escaped, and are decoded as UTF-8
+        QTest::newRow("utf-8") << QByteArray("/media/user/\xc3\xa4pps") << QString::fromUtf8("/media/user/\xc3\xa4pps");
+    }
+
+    void unescapeField() {
+        QFETCH(QByteArray, escaped);
+        QFETCH(QString, expected);
+
+        QCOMPARE(MountMonitor::unescapeField(escaped.toStdString()), expected);
+    }
+};
+
+QTEST_GUILESS_MAIN(MountMonitorTest)
+
+#include "test_mountmonitor.moc"
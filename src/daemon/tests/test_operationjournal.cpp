@@ -0,0 +1,110 @@
+// library includes
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+// local includes
+#include "operationjournal.h"
+
+class OperationJournalTest : public QObject {
+    Q_OBJECT
+
+private:
+    QTemporaryDir tempDir;
+
+    QString journalPath() const {
+        return tempDir.path() + "/operations.journal";
+    }
+
+    std::deque<Operation> replay() const {
+        OperationJournal journal(journalPath());
+        return journal.replay();
+    }
+
+private slots:
+    void init() {
+        QVERIFY(tempDir.isValid());
+        QFile::remove(journalPath());
+    }
+
+    void replaysPendingOperations() {
+        {
+            OperationJournal journal(journalPath());
+            QVERIFY(journal.replay().empty());
+
+            journal.recordScheduled({"/a", INTEGRATE});
+            journal.recordScheduled({"/b", UNINTEGRATE});
+            journal.recordScheduled({"/c", INTEGRATE});
+            journal.recordCompleted("/b");
+        }
+
+        const auto operations = replay();
+
+        QCOMPARE(operations.size(), size_t(2));
+        QCOMPARE(operations[0], Operation("/a", INTEGRATE));
+        QCOMPARE(operations[1], Operation("/c", INTEGRATE));
+
+        // replaying compacts the journal, which must not change its contents
+        QCOMPARE(replay(), operations);
+    }
+
+    void lastRecordOfPathDeterminesState() {
+        {
+            OperationJournal journal(journalPath());
+            journal.replay();
+
+            journal.recordScheduled({"/a", INTEGRATE});
+            journal.recordScheduled({"/b", INTEGRATE});
+            // the file has been removed again before it could be integrated
+            journal.recordScheduled({"/a", UNINTEGRATE});
+            journal.recordCompleted("/b");
+        }
+
+        const auto operations = replay();
+
+        QCOMPARE(operations.size(), size_t(1));
+        QCOMPARE(operations[0], Operation("/a", UNINTEGRATE));
+    }
+
+    void discardsTruncatedRecord() {
+        {
+            OperationJournal journal(journalPath());
+            journal.replay();
+
+            journal.recordScheduled({"/a", INTEGRATE});
+            journal.recordScheduled({"/some/longer/path", INTEGRATE});
+        }
+
+        // cut the last record off in the middle, as if the daemon had been killed while writing it
+        QFile file(journalPath());
+        QVERIFY(file.resize(file.size() - 5));
+
+        const auto operations = replay();
+
+        QCOMPARE(operations.size(), size_t(1));
+        QCOMPARE(operations[0], Operation("/a", INTEGRATE));
+
+        // the journal remains usable afterwards
+        {
+            OperationJournal journal(journalPath());
+            journal.replay();
+            journal.recordScheduled({"/b", INTEGRATE});
+        }
+
+        QCOMPARE(replay().size(), size_t(2));
+    }
+
+    void ignoresUnknownFormat() {
+        {
+            QFile file(journalPath());
+            QVERIFY(file.open(QIODevice::WriteOnly));
+            file.write("not a journal");
+        }
+
+        QVERIFY(replay().empty());
+    }
+};
+
+QTEST_GUILESS_MAIN(OperationJournalTest)
+
+#include "test_operationjournal.moc"
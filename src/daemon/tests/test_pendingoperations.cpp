@@ -0,0 +1,126 @@
+// library includes
+#include <QTest>
+
+// local includes
+#include "pendingoperations.h"
+
+class PendingOperationsTest : public QObject {
+    Q_OBJECT
+
+private:
+    static QStringList paths(const std::deque<Operation>& operations) {
+        QStringList rv;
+
+        for (const auto& operation : operations)
+            rv << operation.first;
+
+        return rv;
+    }
+
+    static std::function<bool(const Operation&)> all() {
+        return [](const Operation&) { return true; };
+    }
+
+private slots:
+    void mergesOperationsOfTheSameType() {
+        PendingOperations operations;
+
+        QCOMPARE(operations.schedule("/a", INTEGRATE), PendingOperations::ADDED);
+        QCOMPARE(operations.schedule("/b", INTEGRATE), PendingOperations::ADDED);
+        QCOMPARE(operations.schedule("/a", INTEGRATE), PendingOperations::MERGED);
+
+        // the merged operation keeps its position
+        QCOMPARE(operations.size(), 2);
+        QCOMPARE(paths(operations.operations()), (QStringList{"/a", "/b"}));
+    }
+
+    void replacesOperationsOfAnotherType() {
+        PendingOperations operations;
+
+        operations.schedule("/a", INTEGRATE);
+        operations.schedule("/b", INTEGRATE);
+
+        QCOMPARE(operations.schedule("/a", UNINTEGRATE), PendingOperations::REPLACED);
+
+        // the replacing operation is moved to the end of the queue
+        const auto pending = operations.operations();
+        QCOMPARE(operations.size(), 2);
+        QCOMPARE(paths(pending), (QStringList{"/b", "/a"}));
+        QCOMPARE(pending.back().second, UNINTEGRATE);
+    }
+
+    void ordersByPriorityClass() {
+        PendingOperations operations;
+
+        operations.schedule("/bulk", INTEGRATE, PRIORITY_BULK, 10);
+        operations.schedule("/main", INTEGRATE, PRIORITY_MAIN_DIRECTORY);
+        operations.schedule("/interactive", INTEGRATE, PRIORITY_INTERACTIVE);
+
+        QCOMPARE(paths(operations.operations()), (QStringList{"/interactive", "/main", "/bulk"}));
+    }
+
+    void ordersBulkOperationsByCost() {
+        PendingOperations operations;
+
+        operations.schedule("/large", INTEGRATE, PRIORITY_BULK, 1000);
+        operations.schedule("/small", INTEGRATE, PRIORITY_BULK, 10);
+        // the cost is ignored in the other classes
+        operations.schedule("/main-large", INTEGRATE, PRIORITY_MAIN_DIRECTORY, 1000);
+        operations.schedule("/main-small", INTEGRATE, PRIORITY_MAIN_DIRECTORY, 10);
+
+        QCOMPARE(paths(operations.operations()), (QStringList{"/main-large", "/main-small", "/small", "/large"}));
+    }
+
+    void mergingWithHigherPriorityMovesUp() {
+        PendingOperations operations;
+
+        operations.schedule("/a", INTEGRATE, PRIORITY_BULK, 10);
+        operations.schedule("/b", INTEGRATE, PRIORITY_MAIN_DIRECTORY);
+
+        QCOMPARE(operations.schedule("/a", INTEGRATE, PRIORITY_INTERACTIVE), PendingOperations::MERGED);
+        QCOMPARE(paths(operations.operations()), (QStringList{"/a", "/b"}));
+
+        // merging with a lower priority doesn't move the operation down
+        QCOMPARE(operations.schedule("/a", INTEGRATE, PRIORITY_BULK, 10), PendingOperations::MERGED);
+        QCOMPARE(paths(operations.operations()), (QStringList{"/a", "/b"}));
+        QVERIFY(operations.containsPriority(PRIORITY_INTERACTIVE));
+    }
+
+    void takesReadyOperationsOfTheGivenClasses() {
+        PendingOperations operations;
+
+        operations.schedule("/interactive", INTEGRATE, PRIORITY_INTERACTIVE);
+        operations.schedule("/not-ready", INTEGRATE, PRIORITY_INTERACTIVE);
+        operations.schedule("/bulk", UNINTEGRATE, PRIORITY_BULK);
+
+        const auto taken = operations.takeIf([](const Operation& operation) {
+            return operation.first != "/not-ready";
+        }, PRIORITY_INTERACTIVE);
+
+        QCOMPARE(taken.size(), size_t(1));
+        QCOMPARE(taken.front().first.first, QString("/interactive"));
+        QCOMPARE(taken.front().second, PRIORITY_INTERACTIVE);
+
+        QVERIFY(!operations.contains("/interactive"));
+        QCOMPARE(paths(operations.operations()), (QStringList{"/not-ready", "/bulk"}));
+
+        QCOMPARE(operations.takeIf(all()).size(), size_t(2));
+        QVERIFY(operations.empty());
+        QVERIFY(!operations.containsPriority(PRIORITY_BULK));
+    }
+
+    void removesOperations() {
+        PendingOperations operations;
+
+        operations.schedule("/a", INTEGRATE);
+        operations.remove("/a");
+        operations.remove("/unknown");
+
+        QVERIFY(operations.empty());
+        QCOMPARE(operations.schedule("/a", UNINTEGRATE), PendingOperations::ADDED);
+    }
+};
+
+QTEST_GUILESS_MAIN(PendingOperationsTest)
+
+#include "test_pendingoperations.moc"
@@ -0,0 +1,144 @@
+// library includes
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+// local includes
+#include "scanstate.h"
+
+class ScanStateTest : public QObject {
+    Q_OBJECT
+
+private:
+    QTemporaryDir tempDir;
+
+    QString statePath() const {
+        return tempDir.path() + "/scan-state";
+    }
+
+    static ScanState::Directory directoryState() {
+        ScanState::Directory directory;
+        directory.mtimeNs = 1234567890123456789ll;
+        directory.entries.emplace("test.AppImage", ScanState::Entry{42, 1024, 987654321, 2});
+        directory.entries.emplace("README", ScanState::Entry{43, 12, 987654322, -1});
+        directory.subdirectories.insert("subdir");
+        return directory;
+    }
+
+    // saves a state containing the given directories
+    void saveState(const QStringList& dirPaths) const {
+        ScanState state(statePath(), "stamp");
+
+        for (const auto& dirPath : dirPaths)
+            state.setDirectory(dirPath, directoryState());
+
+        QVERIFY(state.save());
+    }
+
+    ScanState loadState(const QString& stamp = "stamp") const {
+        ScanState state(statePath(), stamp);
+        state.load();
+        return state;
+    }
+
+private slots:
+    void init() {
+        QVERIFY(tempDir.isValid());
+        QFile::remove(statePath());
+    }
+
+    void savesAndLoadsState() {
+        saveState({"/a"});
+
+        const auto state = loadState();
+        const auto* directory = state.directory("/a");
+
+        QVERIFY(directory != nullptr);
+        QVERIFY(state.directory("/b") == nullptr);
+
+        const auto expected = directoryState();
+        QCOMPARE(directory->mtimeNs, expected.mtimeNs);
+        QCOMPARE(directory->subdirectories, expected.subdirectories);
+        QCOMPARE(directory->entries.size(), expected.entries.size());
+
+        for (const auto& entryPair : expected.entries) {
+            const auto entry = directory->entries.find(entryPair.first);
+
+            QVERIFY(entry != directory->entries.end());
+            QVERIFY(entry->second.isSameFileAs(entryPair.second));
+            QCOMPARE(entry->second.type, entryPair.second.type);
+        }
+    }
+
+    void discardsStateOfOtherStamp() {
+        saveState({"/a"});
+
+        QVERIFY(loadState("other stamp").directory("/a") == nullptr);
+    }
+
+    void discardsStateOfOtherFormatVersion() {
+        saveState({"/a"});
+
+        // the version follows the 32-bit magic number, and is stored in big endian byte order
+        QFile file(statePath());
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        auto contents = file.readAll();
+        contents[7] = static_cast<char>(contents[7] + 1);
+        QVERIFY(file.seek(0));
+        QCOMPARE(file.write(contents), qint64(contents.size()));
+        file.close();
+
+        QVERIFY(loadState().directory("/a") == nullptr);
+    }
+
+    void discardsTruncatedState() {
+        saveState({"/a", "/b"});
+
+        QFile file(statePath());
+        QVERIFY(file.resize(file.size() - 10));
+
+        const auto state = loadState();
+        QVERIFY(state.directory("/a") == nullptr);
+        QVERIFY(state.directory("/b") == nullptr);
+    }
+
+    void prunesUnreachedDirectoriesWithinRoots() {
+        ScanState state(statePath(), "stamp");
+
+        for (const auto& dirPath : {"/root", "/root/reached", "/root/removed", "/rootlike", "/other"})
+            state.setDirectory(dirPath, directoryState());
+
+        state.pruneDirectories({"/root"}, {"/root", "/root/reached"}, false);
+
+        QVERIFY(state.directory("/root") != nullptr);
+        QVERIFY(state.directory("/root/reached") != nullptr);
+        QVERIFY(state.directory("/root/removed") == nullptr);
+        // directories outside the roots haven't been scanned, so nothing is known about them
+        QVERIFY(state.directory("/rootlike") != nullptr);
+        QVERIFY(state.directory("/other") != nullptr);
+    }
+
+    void prunesAllUnreachedDirectoriesOnFullScans() {
+        ScanState state(statePath(), "stamp");
+
+        for (const auto& dirPath : {"/root", "/root/removed", "/unwatched"})
+            state.setDirectory(dirPath, directoryState());
+
+        state.pruneDirectories({"/root"}, {"/root"}, true);
+
+        QVERIFY(state.directory("/root") != nullptr);
+        QVERIFY(state.directory("/root/removed") == nullptr);
+        QVERIFY(state.directory("/unwatched") == nullptr);
+
+        // the pruned state is what gets persisted
+        QVERIFY(state.save());
+
+        const auto loadedState = loadState();
+        QVERIFY(loadedState.directory("/root") != nullptr);
+        QVERIFY(loadedState.directory("/root/removed") == nullptr);
+    }
+};
+
+QTEST_GUILESS_MAIN(ScanStateTest)
+
+#include "test_scanstate.moc"
@@ -0,0 +1,120 @@
+// library includes
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+
+// local includes
+#include "settletracker.h"
+
+class SettleTrackerTest : public QObject {
+    Q_OBJECT
+
+private:
+    QTemporaryDir tempDir;
+
+    QString filePath() const {
+        return tempDir.path() + "/test.AppImage";
+    }
+
+    // appends to the file, which changes its size
+    void writeToFile() const {
+        QFile file(filePath());
+        QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Append));
+        QCOMPARE(file.write("data"), qint64(4));
+    }
+
+private slots:
+    void init() {
+        QVERIFY(tempDir.isValid());
+        QFile::remove(filePath());
+        writeToFile();
+    }
+
+    void reportsUnchangedFilesAfterSettleTime() {
+        SettleTracker tracker(100, 1000);
+        tracker.track(filePath());
+
+        QVERIFY(tracker.isTracked(filePath()));
+        QVERIFY(tracker.checkSettled().empty());
+        QVERIFY(tracker.msUntilNextCheck() > 50);
+
+        QTest::qSleep(120);
+
+        QCOMPARE(tracker.msUntilNextCheck(), qint64(0));
+        QCOMPARE(tracker.checkSettled(), QStringList{filePath()});
+        QVERIFY(!tracker.isTracked(filePath()));
+        QVERIFY(tracker.empty());
+        QCOMPARE(tracker.msUntilNextCheck(), qint64(-1));
+    }
+
+    void backsOffWhileFilesKeepChanging() {
+        SettleTracker tracker(100, 300);
+        tracker.track(filePath());
+
+        QTest::qSleep(120);
+        writeToFile();
+
+        // the interval is doubled
+        QVERIFY(tracker.checkSettled().empty());
+        QVERIFY(tracker.msUntilNextCheck() > 150);
+        QVERIFY(tracker.msUntilNextCheck() <= 200);
+
+        QTest::qSleep(220);
+        writeToFile();
+
+        // but not beyond the maximum interval
+        QVERIFY(tracker.checkSettled().empty());
+        QVERIFY(tracker.msUntilNextCheck() > 250);
+        QVERIFY(tracker.msUntilNextCheck() <= 300);
+
+        QTest::qSleep(320);
+
+        QCOMPARE(tracker.checkSettled(), QStringList{filePath()});
+    }
+
+    void restartsSettleTimeOnChanges() {
+        SettleTracker tracker(100, 1000);
+        tracker.track(filePath());
+
+        QTest::qSleep(60);
+        writeToFile();
+        tracker.track(filePath());
+
+        QVERIFY(tracker.msUntilNextCheck() > 60);
+        QVERIFY(tracker.checkSettled().empty());
+    }
+
+    void reportsRemovedFilesAsSettled() {
+        SettleTracker tracker(100, 1000);
+        tracker.track(filePath());
+
+        QVERIFY(QFile::remove(filePath()));
+        QTest::qSleep(120);
+
+        QCOMPARE(tracker.checkSettled(), QStringList{filePath()});
+    }
+
+    void forgetsFiles() {
+        SettleTracker tracker(100, 1000);
+        tracker.track(filePath());
+        tracker.forget(filePath());
+
+        QVERIFY(tracker.empty());
+        QCOMPARE(tracker.msUntilNextCheck(), qint64(-1));
+
+        QTest::qSleep(120);
+        QVERIFY(tracker.checkSettled().empty());
+    }
+
+    void enforcesMinimumSettleTime() {
+        // a settle time of 0 would make the daemon check files which keep changing in a busy loop
+        SettleTracker tracker(0, 0);
+        tracker.track(filePath());
+
+        QVERIFY(tracker.msUntilNextCheck() > 50);
+    }
+};
+
+QTEST_GUILESS_MAIN(SettleTrackerTest)
+
+#include "test_settletracker.moc"
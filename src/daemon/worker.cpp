@@ -1,51 +1,159 @@
 // system includes
+#include <algorithm>
 #include <atomic>
+#include <cerrno>
+#include <cstring>
 #include <iostream>
 #include <deque>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 // library includes
 #include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
+#include <QFileInfo>
 #include <QObject>
 #include <QSysInfo>
 #include <QTimer>
+#include <QThread>
 #include <QThreadPool>
 #include <QMutexLocker>
 #include <appimage/appimage.h>
 
 // local includes
 #include "worker.h"
+#include "metrics.h"
+#include "operationjournal.h"
+#include "pendingoperations.h"
+#include "settletracker.h"
 #include "shared.h"
 
-enum OP_TYPE {
-    INTEGRATE = 0,
-    UNINTEGRATE = 1,
-};
+// glibc doesn't provide a wrapper for ioprio_set(2), therefore we need to define the constants ourselves
+// see linux/ioprio.h
+#define IOPRIO_CLASS_SHIFT 13
+#define IOPRIO_CLASS_IDLE 3
+#define IOPRIO_WHO_PROCESS 1
+
+// lowers the CPU and I/O priority of the calling thread, so that integrating AppImages in the background doesn't
+// compete with foreground applications
+// both scheduling policy and I/O priority are per thread on Linux, therefore this affects only the calling thread
+// unprivileged threads can't raise their priorities again, so this must only be called on threads of the background
+// pool
+static void makeCurrentThreadBackgroundThread() {
+    // the pool reuses its threads, it's sufficient to do this once per thread
+    static thread_local bool done = false;
+
+    if (done)
+        return;
+
+    done = true;
+
+    struct sched_param param{};
+    param.sched_priority = 0;
+
+    if (pthread_setschedparam(pthread_self(), SCHED_IDLE, &param) != 0) {
+        // the nice value is per thread on Linux, too
+        if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19) != 0) {
+            const auto error = errno;
+            std::cerr << "Warning: failed to lower CPU priority of worker thread: " << strerror(error) << std::endl;
+        }
+    }
 
-typedef std::pair<QString, OP_TYPE> Operation;
+    // who = 0 refers to the calling thread
+    if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT) != 0) {
+        const auto error = errno;
+        std::cerr << "Warning: failed to lower I/O priority of worker thread: " << strerror(error) << std::endl;
+    }
+}
 
 class Worker::PrivateData {
 public:
     QTimer deferredOperationsTimer;
 
-    static constexpr int TIMEOUT = 15 * 1000;
-
-    // std::set is unordered, therefore using std::deque to keep the order of the operations
-    std::deque<Operation> deferredOperations;
+    // time files need to remain unchanged before they are integrated
+    static constexpr int DEFAULT_SETTLE_TIME = 2 * 1000;
+    // shorter settle times would make the daemon check files which keep changing almost continuously
+    static constexpr int MIN_SETTLE_TIME = 100;
+    // files which keep changing are checked at most this far apart
+    static constexpr int MAX_SETTLE_CHECK_INTERVAL = 60 * 1000;
+
+    // indexed by path, and keeps the order of the operations
+    PendingOperations deferredOperations;
+
+    // files to be integrated might still be written to, so we wait for them to settle before integrating them
+    SettleTracker settleTracker;
+
+    // allows for resuming the pending operations after a crash or restart
+    OperationJournal journal;
+
+    std::shared_ptr<DaemonMetrics> metrics;
+
+    // AppImages found in there by scans are integrated before the ones found in other directories
+    QDir integrationDirectory;
+
+    // the daemon's own pool, so that its size can be configured independently of the number of CPU cores, and the
+    // threads' priorities can be lowered without affecting other users of the global instance
+    QThreadPool pool;
+    // runs the interactive operations, which clients may be waiting for, at normal priority
+    // on a busy machine, threads with idle priority might not get to run at all for a long time
+    QThreadPool interactivePool;
+
+    // number of operations of the current batch which have not finished yet
+    int pendingTasks = 0;
+    // incremented whenever operations are started, tells completions of operations started before and after a point
+    quint64 generation = 0;
+    // true while a batch (including its clean up step) is being executed
+    bool batchRunning = false;
+    // set when clients have requested operations, which are then executed without waiting for the batch interval
+    bool requestsPending = false;
+    // set when the desktop integration resources of removed AppImages shall be cleaned up with the next batch
+    bool cleanUpRequested = false;
 
     class OperationTask : public QRunnable {
     private:
         Operation operation;
+        quint64 generation;
+        bool background;
         std::shared_ptr<QMutex> mutex;
+        std::shared_ptr<DaemonMetrics> metrics;
+        Worker* worker;
 
     public:
-        OperationTask(const Operation& operation, std::shared_ptr<QMutex> mutex) : operation(operation),
-                                                                                   mutex(std::move(mutex)) {}
+        OperationTask(const Operation& operation, quint64 generation, bool background, std::shared_ptr<QMutex> mutex,
+                      std::shared_ptr<DaemonMetrics> metrics, Worker* worker) :
+            operation(operation),
+            generation(generation),
+            background(background),
+            mutex(std::move(mutex)),
+            metrics(std::move(metrics)),
+            worker(worker) {}
 
         void run() override {
+            if (background)
+                makeCurrentThreadBackgroundThread();
+
+            const auto result = runOperation();
+            metrics->recordOperation(result);
+
+            // the worker lives in another thread, therefore we have to notify it through its event loop
+            QMetaObject::invokeMethod(worker, "operationFinished", Qt::QueuedConnection,
+                                      Q_ARG(QString, operation.first), Q_ARG(bool, result != DaemonMetrics::FAILED),
+                                      Q_ARG(quint64, generation));
+        }
+
+    private:
+        DaemonMetrics::Result runOperation() {
             const auto& path = operation.first;
             const auto& type = operation.second;
 
+            QElapsedTimer probeTimer;
+            probeTimer.start();
+
             const auto exists = QFile::exists(path);
             const auto appImageType = appimage_get_type(path.toStdString().c_str(), false);
             const auto isAppImage = 0 < appImageType && appImageType <= 2;
@@ -57,12 +165,12 @@ public:
 
                     if (!exists) {
                         std::cout << "ERROR: file does not exist, cannot integrate" << std::endl;
-                        return;
+                        return DaemonMetrics::FAILED;
                     }
 
                     if (!isAppImage) {
                         std::cout << "ERROR: not an AppImage, skipping" << std::endl;
-                        return;
+                        return DaemonMetrics::SKIPPED;
                     }
                 }
 
@@ -70,104 +178,445 @@ public:
                 if (appimage_shall_not_be_integrated(path.toStdString().c_str())) {
                     QMutexLocker mutexLocker(mutex.get());
                     std::cout << "WARNING: AppImage shall not be integrated, skipping" << std::endl;
-                    return;
+                    return DaemonMetrics::SKIPPED;
                 }
 
-                if (!installDesktopFileAndIcons(path)) {
+                metrics->recordLatency(DaemonMetrics::PROBE, probeTimer.elapsed());
+
+                DesktopIntegrationTimings timings;
+                const auto success = installDesktopFileAndIcons(path, true, &timings);
+
+                if (timings.registerMs >= 0)
+                    metrics->recordLatency(DaemonMetrics::REGISTER, timings.registerMs);
+                if (timings.desktopFileMs >= 0)
+                    metrics->recordLatency(DaemonMetrics::DESKTOP_FILE, timings.desktopFileMs);
+
+                if (!success) {
                     QMutexLocker mutexLocker(mutex.get());
                     std::cout << "ERROR: Failed to register AppImage in system" << std::endl;
-                    return;
+                    return DaemonMetrics::FAILED;
                 }
-            } else if (type == UNINTEGRATE) {
-                // nothing to do
+
+                return DaemonMetrics::INTEGRATED;
+            } else if (type == UNINTEGRATE || type == FORCE_UNINTEGRATE) {
+                // the file might have been re-created in the meantime (e.g., when it has been replaced by moving
+                // another file there), in which case the integration is taken care of by the integration operation
+                if (type == UNINTEGRATE && exists) {
+                    QMutexLocker mutexLocker(mutex.get());
+                    std::cout << "File exists again, not unintegrating: " << path.toStdString() << std::endl;
+                    return DaemonMetrics::SKIPPED;
+                }
+
+                // most removed files (e.g., temporary download files) have never been integrated
+                if (!hasAlreadyBeenIntegrated(path))
+                    return DaemonMetrics::SKIPPED;
+
+                {
+                    QMutexLocker mutexLocker(mutex.get());
+                    std::cout << "Unintegrating: " << path.toStdString() << std::endl;
+                }
+
+                // the desktop integration resources are named after the path, so we can remove exactly the ones
+                // belonging to this file without having to look at any other integrated AppImage
+                if (!unregisterAppImage(path)) {
+                    QMutexLocker mutexLocker(mutex.get());
+                    std::cout << "ERROR: Failed to unregister AppImage" << std::endl;
+                    return DaemonMetrics::FAILED;
+                }
+
+                return DaemonMetrics::UNINTEGRATED;
+            }
+
+            return DaemonMetrics::SKIPPED;
+        }
+    };
+
+    // runs after all operations of a batch have finished
+    class FinishBatchTask : public QRunnable {
+    private:
+        std::shared_ptr<DaemonMetrics> metrics;
+        bool cleanUp;
+        Worker* worker;
+
+    public:
+        FinishBatchTask(std::shared_ptr<DaemonMetrics> metrics, bool cleanUp, Worker* worker) :
+            metrics(std::move(metrics)),
+            cleanUp(cleanUp),
+            worker(worker) {}
+
+        void run() override {
+            makeCurrentThreadBackgroundThread();
+
+            // removed AppImages have been unintegrated one by one already, there is no need to look at all the other
+            // desktop files, unless events might have been lost (see requestCleanUp())
+            if (cleanUp) {
+                std::cout << "Cleaning up old desktop integration resources" << std::endl;
+
+                if (!cleanUpOldDesktopIntegrationResources(true))
+                    std::cerr << "Error: Failed to clean up old desktop integration resources" << std::endl;
             }
+
+            // make sure the icons in the launcher are refreshed
+            std::cout << "Updating desktop database and icon caches" << std::endl;
+
+            QElapsedTimer timer;
+            timer.start();
+
+            if (!updateDesktopDatabaseAndIconCaches())
+                std::cout << "Failed to update desktop database and icon caches" << std::endl;
+
+            metrics->recordLatency(DaemonMetrics::CACHE_REFRESH, timer.elapsed());
+
+            std::cout << "Done" << std::endl;
+
+            QMetaObject::invokeMethod(worker, "batchFinished", Qt::QueuedConnection);
         }
     };
 
 public:
-    PrivateData() {
+    PrivateData(int settleTime, int integrationThreads, std::shared_ptr<DaemonMetrics> metrics) :
+        settleTracker(settleTime, MAX_SETTLE_CHECK_INTERVAL),
+        journal(OperationJournal::defaultPath()),
+        metrics(std::move(metrics)),
+        integrationDirectory(integratedAppImagesDestination()) {
         deferredOperationsTimer.setSingleShot(true);
-        deferredOperationsTimer.setInterval(TIMEOUT);
+        deferredOperationsTimer.setInterval(settleTime);
+
+        pool.setMaxThreadCount(integrationThreads);
+        interactivePool.setMaxThreadCount(integrationThreads);
     }
 
-public:
-    // in addition to a simple duplicate check, this function is context sensitive
-    // it starts with the last element, and checks for duplicates until an opposite action is found
-    // for instance, when the element shall integrated, it will check for duplicates until an unintegration operation
-    // is found
-    bool isDuplicate(Operation operation) {
-        for (auto it = deferredOperations.rbegin(); it != deferredOperations.rend(); ++it) {
-            if ((*it).first == operation.first) {
-                // if operation type is different, then the operation is new, and should be added to the list
-                // if it is equal, it's a duplicate
-                // in either case, the loop can be aborted here
-                return (*it).second == operation.second;
+    static int settleTimeFromConfig() {
+        const auto config = getConfig();
+
+        if (config == nullptr)
+            return DEFAULT_SETTLE_TIME;
+
+        bool ok = false;
+        const auto value = config->value("appimagelauncherd/settle_time_ms", DEFAULT_SETTLE_TIME).toInt(&ok);
+
+        if (!ok) {
+            std::cerr << "Warning: invalid value for settle_time_ms, using default" << std::endl;
+            return DEFAULT_SETTLE_TIME;
+        }
+
+        if (value < MIN_SETTLE_TIME) {
+            std::cerr << "Warning: settle_time_ms must be at least " << MIN_SETTLE_TIME << ", using that instead"
+                      << std::endl;
+            return MIN_SETTLE_TIME;
+        }
+
+        return value;
+    }
+
+    static int integrationThreadsFromConfig() {
+        const auto defaultValue = QThread::idealThreadCount();
+
+        const auto config = getConfig();
+
+        if (config == nullptr)
+            return defaultValue;
+
+        bool ok = false;
+        const auto value = config->value("appimagelauncherd/integration_threads", defaultValue).toInt(&ok);
+
+        if (!ok || value < 1) {
+            std::cerr << "Warning: invalid value for integration_threads, using default" << std::endl;
+            return defaultValue;
+        }
+
+        return value;
+    }
+
+    // priority class of AppImages which have been found by a scan rather than an event
+    OP_PRIORITY scannedFilePriority(const QString& path) const {
+        if (isInDirectory(path, integrationDirectory))
+            return PRIORITY_MAIN_DIRECTORY;
+
+        return PRIORITY_BULK;
+    }
+
+    // higher priority classes are dispatched to the pool's queue ahead of lower ones
+    static int poolPriority(OP_PRIORITY priority) {
+        return PRIORITY_BULK - priority;
+    }
+
+    // adds an operation to the queue, and records it in the journal
+    // returns false if it has been merged into a pending operation
+    bool schedule(const QString& path, OP_TYPE type, OP_PRIORITY priority = PRIORITY_INTERACTIVE, quint64 cost = 0) {
+        if (deferredOperations.schedule(path, type, priority, cost) == PendingOperations::MERGED)
+            return false;
+
+        journal.recordScheduled(std::make_pair(path, type));
+        return true;
+    }
+
+    // removes all operations of at least the given priority class which are ready to be executed from the queue,
+    // keeping the order of the operations
+    // an operation is ready unless it integrates a file which hasn't settled yet
+    std::deque<PrioritizedOperation> takeReadyOperations(OP_PRIORITY lowestPriority = PRIORITY_BULK) {
+        const auto& tracker = settleTracker;
+
+        return deferredOperations.takeIf([&tracker](const Operation& operation) {
+            return operation.second != INTEGRATE || !tracker.isTracked(operation.first);
+        }, lowestPriority);
+    }
+
+    void startFinishBatchTask(Worker* worker) {
+        pool.start(new FinishBatchTask(metrics, cleanUpRequested, worker));
+        cleanUpRequested = false;
+    }
+
+    void startOperations(std::deque<PrioritizedOperation> operations, Worker* worker) {
+        auto outputMutex = std::make_shared<QMutex>();
+
+        pendingTasks += static_cast<int>(operations.size());
+        ++generation;
+
+        while (!operations.empty()) {
+            const auto operation = operations.front();
+            operations.pop_front();
+
+            if (operation.second == PRIORITY_INTERACTIVE) {
+                interactivePool.start(new OperationTask(operation.first, generation, false, outputMutex, metrics,
+                                                        worker));
+                continue;
             }
+
+            pool.start(new OperationTask(operation.first, generation, true, outputMutex, metrics, worker),
+                       poolPriority(operation.second));
         }
+    }
+
+    // interval after which the pending operations should be checked again
+    int nextCheckInterval() const {
+        if (requestsPending)
+            return 0;
 
-        return false;
+        const auto msUntilNextCheck = settleTracker.msUntilNextCheck();
+
+        // if no files need to settle, pending operations (e.g., unintegrations) are batched for the default interval
+        if (msUntilNextCheck < 0)
+            return deferredOperationsTimer.interval();
+
+        return static_cast<int>(msUntilNextCheck);
     }
 };
 
-Worker::Worker() {
-    d = std::make_shared<PrivateData>();
+Worker::Worker(std::shared_ptr<DaemonMetrics> metrics) {
+    d = std::make_shared<PrivateData>(
+        PrivateData::settleTimeFromConfig(),
+        PrivateData::integrationThreadsFromConfig(),
+        std::move(metrics)
+    );
+
+    std::cout << "Using up to " << d->pool.maxThreadCount() << " threads for integration" << std::endl;
+
+    // resume the operations which were still pending when the daemon stopped
+    // integrations are checked for having settled, as the files might have still been written to back then
+    // nobody is waiting for these, therefore they're treated like the results of a scan
+    for (const auto& operation : d->journal.replay()) {
+        if (operation.second == INTEGRATE)
+            d->settleTracker.track(operation.first);
+
+        d->deferredOperations.schedule(operation.first, operation.second, d->scannedFilePriority(operation.first),
+                                       static_cast<quint64>(QFileInfo(operation.first).size()));
+    }
+
+    if (!d->deferredOperations.empty()) {
+        std::cout << "Resuming " << d->deferredOperations.size() << " operations from journal" << std::endl;
+    }
 
     connect(this, &Worker::startTimer, this, &Worker::startTimerIfNecessary, Qt::QueuedConnection);
-    connect(&d->deferredOperationsTimer, &QTimer::timeout, this, &Worker::executeDeferredOperations);
+    connect(&d->deferredOperationsTimer, &QTimer::timeout, this, &Worker::checkSettledOperations);
+
+    // the event loop isn't running yet, the signal is delivered as soon as it is
+    if (!d->deferredOperations.empty())
+        emit startTimer();
+}
+
+Worker::~Worker() {
+    // the tasks notify this object when they're done, therefore we must not go away before they have finished
+    d->interactivePool.waitForDone();
+    d->pool.waitForDone();
+}
+
+void Worker::checkSettledOperations() {
+    // the requested operations are executed now, or join the running batch if possible
+    d->requestsPending = false;
+
+    const auto settledPaths = d->settleTracker.checkSettled();
+
+    for (const auto& path : settledPaths) {
+        qDebug() << "File has settled:" << path;
+    }
+
+    executeDeferredOperations();
+
+    // some files might still be changing, we need to check them again later
+    if (!d->deferredOperations.empty())
+        emit startTimer();
 }
 
 void Worker::executeDeferredOperations() {
-    if (d->deferredOperations.empty()) {
-        qDebug() << "No deferred operations to execute";
+    // operations are executed in batches, so that the clean up and cache update steps need to run only once per batch
+    // new operations are queued in the meantime, and will be executed in the next batch
+    // interactive operations must not wait for a large batch, though, so they join the running one, and overtake its
+    // operations which haven't been started yet
+    // once all operations of a batch have finished, the clean up step is running already, and it's too late to join
+    if (d->batchRunning) {
+        if (d->pendingTasks > 0 && d->deferredOperations.containsPriority(PRIORITY_INTERACTIVE)) {
+            auto interactiveOperations = d->takeReadyOperations(PRIORITY_INTERACTIVE);
+
+            if (!interactiveOperations.empty()) {
+                std::cout << "Adding " << interactiveOperations.size() << " interactive operations to running batch"
+                          << std::endl;
+                d->startOperations(std::move(interactiveOperations), this);
+                return;
+            }
+        }
+
+        qDebug() << "Batch is still running, deferring execution of operations";
         return;
     }
 
-    std::cout << "Executing deferred operations" << std::endl;
+    auto readyOperations = d->takeReadyOperations();
 
-    auto outputMutex = std::make_shared<QMutex>();
+    if (readyOperations.empty()) {
+        // a requested clean up doesn't have to wait for any operations
+        if (d->cleanUpRequested) {
+            d->batchRunning = true;
+            d->pendingTasks = 0;
+            d->startFinishBatchTask(this);
+            return;
+        }
 
-    while (!d->deferredOperations.empty()) {
-        auto operation = d->deferredOperations.front();
-        d->deferredOperations.pop_front();
-        QThreadPool::globalInstance()->start(new PrivateData::OperationTask(operation, outputMutex));
+        qDebug() << "No deferred operations ready to be executed";
+        return;
     }
 
-    // wait until all AppImages have been integrated
-    QThreadPool::globalInstance()->waitForDone();
+    std::cout << "Executing deferred operations" << std::endl;
 
-    std::cout << "Cleaning up old desktop integration files" << std::endl;
-    if (!cleanUpOldDesktopIntegrationResources(true)) {
-        std::cout << "Failed to clean up old desktop integration files" << std::endl;
-    }
+    d->batchRunning = true;
+    d->pendingTasks = 0;
 
-    // make sure the icons in the launcher are refreshed
-    std::cout << "Updating desktop database and icon caches" << std::endl;
-    if (!updateDesktopDatabaseAndIconCaches())
-        std::cout << "Failed to update desktop database and icon caches" << std::endl;
+    d->startOperations(std::move(readyOperations), this);
+}
+
+void Worker::operationFinished(const QString& path, bool success, quint64 generation) {
+    // if the path has been scheduled again in the meantime, the journal must keep the newer operation
+    // failed operations are not retried, therefore they are completed, too
+    if (!d->deferredOperations.contains(path))
+        d->journal.recordCompleted(path);
+
+    emit operationCompleted(path, success, generation);
+
+    if (--d->pendingTasks > 0)
+        return;
 
-    std::cout << "Done" << std::endl;
+    // all AppImages of this batch have been processed, time to clean up and refresh the caches
+    d->startFinishBatchTask(this);
+}
+
+void Worker::batchFinished() {
+    d->batchRunning = false;
+
+    d->journal.compactIfNecessary();
+
+    // requests which couldn't join the batch shouldn't have to wait any longer
+    if (d->deferredOperations.containsPriority(PRIORITY_INTERACTIVE))
+        d->requestsPending = true;
+
+    // operations or a clean up might have been requested while the batch was running
+    if (!d->deferredOperations.empty() || d->cleanUpRequested)
+        emit startTimer();
 }
 
 void Worker::scheduleForIntegration(const QString& path) {
-    auto operation = std::make_pair(path, INTEGRATE);
-    if (!d->isDuplicate(operation)) {
-        std::cout << "Scheduling for (re-)integration: " << path.toStdString() << std::endl;
-        d->deferredOperations.push_back(operation);
+    // every event restarts the settle time, even if the operation itself is merged into a pending one
+    d->settleTracker.track(path);
+
+    if (d->schedule(path, INTEGRATE)) {
+        std::cout << "Scheduling for (re-)integration: " << path.toStdString()
+                  << " (queue depth: " << d->deferredOperations.size() << ")" << std::endl;
         emit startTimer();
     }
+}
 
+void Worker::scheduleScannedForIntegration(const QString& path, qint64 size) {
+    d->settleTracker.track(path);
+
+    if (d->schedule(path, INTEGRATE, d->scannedFilePriority(path), static_cast<quint64>(std::max<qint64>(size, 0)))) {
+        std::cout << "Scheduling for (re-)integration after scan: " << path.toStdString()
+                  << " (queue depth: " << d->deferredOperations.size() << ")" << std::endl;
+        emit startTimer();
+    }
 }
 
 void Worker::scheduleForUnintegration(const QString& path) {
-    auto operation = std::make_pair(path, UNINTEGRATE);
-    if (!d->isDuplicate(operation)) {
-        std::cout << "Scheduling for unintegration: " << path.toStdString() << std::endl;
-        d->deferredOperations.push_back(operation);
+    // there's no point in waiting for a file to settle which has been removed
+    d->settleTracker.forget(path);
+
+    if (d->schedule(path, UNINTEGRATE)) {
+        std::cout << "Scheduling for unintegration: " << path.toStdString()
+                  << " (queue depth: " << d->deferredOperations.size() << ")" << std::endl;
         emit startTimer();
     }
 }
 
+void Worker::requestIntegration(const QString& path) {
+    // the client tells us the file is complete, so there's no need to wait for it to settle, even if the file has
+    // been seen changing before
+    d->settleTracker.forget(path);
+
+    // the operation is executed right away, together with the other requests received in the meantime
+    if (d->schedule(path, INTEGRATE)) {
+        std::cout << "Integration requested: " << path.toStdString()
+                  << " (queue depth: " << d->deferredOperations.size() << ")" << std::endl;
+    }
+
+    // even if the request has been merged into a pending operation, that one must be executed now
+    d->requestsPending = true;
+    emit startTimer();
+}
+
+void Worker::requestUnintegration(const QString& path) {
+    d->settleTracker.forget(path);
+
+    if (d->schedule(path, FORCE_UNINTEGRATE)) {
+        std::cout << "Unintegration requested: " << path.toStdString()
+                  << " (queue depth: " << d->deferredOperations.size() << ")" << std::endl;
+    }
+
+    d->requestsPending = true;
+    emit startTimer();
+}
+
+void Worker::requestCleanUp() {
+    d->cleanUpRequested = true;
+    emit startTimer();
+}
+
+void Worker::setIntegrationDirectory(const QDir& directory) {
+    d->integrationDirectory = directory;
+}
+
+int Worker::queueDepth() const {
+    return d->deferredOperations.size();
+}
+
+quint64 Worker::currentGeneration() const {
+    return d->generation;
+}
+
+bool Worker::isPending(const QString& path) const {
+    return d->deferredOperations.contains(path);
+}
+
 void Worker::startTimerIfNecessary() {
-    if (!d->deferredOperationsTimer.isActive())
-        QMetaObject::invokeMethod(&d->deferredOperationsTimer, "start");
+    const auto interval = d->nextCheckInterval();
+
+    // the timer might be waiting for a file which keeps changing, but another file might be due earlier
+    if (!d->deferredOperationsTimer.isActive() || d->deferredOperationsTimer.remainingTime() > interval)
+        d->deferredOperationsTimer.start(interval);
 }
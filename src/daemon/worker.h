@@ -2,8 +2,12 @@
 #include <memory>
 
 // library includes
+#include <QDir>
 #include <QObject>
 
+// local includes
+#include "metrics.h"
+
 #pragma once
 
 class Worker : public QObject {
@@ -14,18 +18,55 @@ private:
     std::shared_ptr<PrivateData> d = nullptr;
 
 public:
-    Worker();
+    // the worker records the operations it executes in the metrics object
+    explicit Worker(std::shared_ptr<DaemonMetrics> metrics);
+    ~Worker() override;
+
+public:
+    // AppImages found by scans of this directory are integrated before the ones found in other directories
+    void setIntegrationDirectory(const QDir& directory);
+
+    // number of operations waiting to be executed
+    int queueDepth() const;
+
+    // checks whether an operation for the given path is waiting to be executed
+    bool isPending(const QString& path) const;
+
+    // operations started from now on are reported with a higher generation than the one returned
+    // allows for telling whether a completed operation has been scheduled before or after a certain point
+    quint64 currentGeneration() const;
 
 signals:
     void startTimer();
 
+    // emitted whenever an operation has been executed
+    // generation is the one the worker reported when starting the operation, see currentGeneration()
+    void operationCompleted(QString path, bool success, quint64 generation);
+
 public slots:
+    // operations caused by file system events, which are executed before the ones found by scans
     void scheduleForIntegration(const QString& path);
     void scheduleForUnintegration(const QString& path);
 
+    // AppImages found by scans, which may find a lot of them at once
+    // the ones in the integration directory are integrated first, smaller files before larger ones in the others
+    void scheduleScannedForIntegration(const QString& path, qint64 size);
+
+    // operations explicitly requested by clients
+    // unlike the ones above, these don't wait for the file to settle, and unintegrate files even if they still exist
+    void requestIntegration(const QString& path);
+    void requestUnintegration(const QString& path);
+
+    // cleans up the desktop integration resources of all AppImages which don't exist any more in the background, as
+    // part of the next batch
+    void requestCleanUp();
+
 public slots:
     void executeDeferredOperations();
 
 private slots:
     void startTimerIfNecessary();
+    void checkSettledOperations();
+    void operationFinished(const QString& path, bool success, quint64 generation);
+    void batchFinished();
 };
@@ -0,0 +1,332 @@
+// system includes
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#ifdef HAVE_FANOTIFY_DFID_NAME
+#include <fcntl.h>
+#include <sys/fanotify.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+#endif
+
+// library includes
+#include <QDebug>
+#include <QDir>
+#ifdef HAVE_FANOTIFY_DFID_NAME
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#endif
+
+// local includes
+#include "fanotifybackend.h"
+
+#ifdef HAVE_FANOTIFY_DFID_NAME
+
+class FanotifyBackend::PrivateData {
+public:
+    static constexpr auto markMask = FAN_CLOSE_WRITE | FAN_CREATE | FAN_DELETE | FAN_MOVED_FROM | FAN_MOVED_TO |
+                                     FAN_ONDIR;
+
+    int fanotifyFd = -1;
+
+    // the roots of the followed filesystems, which are watched for Applications directories being created
+    QHash<QByteArray, QString> mountPointsByHandle;
+
+    // the Applications directories of the followed filesystems, and all their subdirectories
+    QHash<QByteArray, QString> directoriesByHandle;
+
+    QSet<QString> followedMountPoints;
+
+    std::vector<char> readBuffer = std::vector<char>(64 * 1024);
+
+public:
+    ~PrivateData() {
+        if (fanotifyFd >= 0)
+            close(fanotifyFd);
+    }
+
+    // builds the key to look up the directories by, consisting of the filesystem ID and the file handle, as reported
+    // by fanotify
+    static QByteArray key(const __kernel_fsid_t& fsid, const struct file_handle* handle) {
+        QByteArray rv(reinterpret_cast<const char*>(&fsid), sizeof(fsid));
+        rv.append(reinterpret_cast<const char*>(&handle->handle_type), sizeof(handle->handle_type));
+        rv.append(reinterpret_cast<const char*>(handle->f_handle), static_cast<int>(handle->handle_bytes));
+        return rv;
+    }
+
+    // returns an empty key if the path's handle can't be determined
+    static QByteArray key(const QString& path) {
+        const auto pathStr = path.toStdString();
+
+        struct statfs fsStat{};
+
+        if (statfs(pathStr.c_str(), &fsStat) != 0)
+            return {};
+
+        std::vector<char> handleBuffer(sizeof(struct file_handle) + MAX_HANDLE_SZ);
+        auto* handle = reinterpret_cast<struct file_handle*>(handleBuffer.data());
+        handle->handle_bytes = MAX_HANDLE_SZ;
+
+        int mountId = 0;
+
+        if (name_to_handle_at(AT_FDCWD, pathStr.c_str(), handle, &mountId, 0) != 0)
+            return {};
+
+        __kernel_fsid_t fsid{};
+        static_assert(sizeof(fsid) == sizeof(fsStat.f_fsid), "unexpected size of fsid");
+        memcpy(&fsid, &fsStat.f_fsid, sizeof(fsid));
+
+        return key(fsid, handle);
+    }
+
+    // registers the handles of the given directory and all its subdirectories, except for hidden ones
+    void addTree(const QString& rootPath) {
+        QStringList queue{rootPath};
+
+        while (!queue.empty()) {
+            const auto path = queue.takeFirst();
+            const auto handleKey = key(path);
+
+            if (handleKey.isEmpty()) {
+                qDebug() << "Could not determine file handle of" << path;
+                continue;
+            }
+
+            directoriesByHandle.insert(handleKey, path);
+
+            const QDir dir(path);
+
+            for (const auto& name : dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks)) {
+                queue << dir.absoluteFilePath(name);
+            }
+        }
+    }
+
+    // forgets about the given directory and all its subdirectories
+    // as they might not exist any more, the handles can't be determined from their paths
+    void removeTree(const QString& rootPath) {
+        auto it = directoriesByHandle.begin();
+
+        while (it != directoriesByHandle.end()) {
+            if (it.value() == rootPath || it.value().startsWith(rootPath + "/")) {
+                it = directoriesByHandle.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void handleEvent(const struct fanotify_event_metadata* metadata, std::vector<Event>& events) {
+        if (metadata->mask & FAN_Q_OVERFLOW) {
+            std::cerr << "Warning: fanotify event queue overflowed, events have been lost" << std::endl;
+            events.push_back({Event::EVENTS_LOST, QString()});
+            return;
+        }
+
+        // with FAN_REPORT_DFID_NAME, the first info record describes the directory the event occurred in
+        if (metadata->event_len <= metadata->metadata_len)
+            return;
+
+        const auto* info = reinterpret_cast<const struct fanotify_event_info_fid*>(
+            reinterpret_cast<const char*>(metadata) + metadata->metadata_len
+        );
+
+        if (info->hdr.info_type != FAN_EVENT_INFO_TYPE_DFID_NAME)
+            return;
+
+        const auto* handle = reinterpret_cast<const struct file_handle*>(info->handle);
+        const auto* name = reinterpret_cast<const char*>(handle->f_handle + handle->handle_bytes);
+
+        const auto handleKey = key(info->fsid, handle);
+        const auto isDirectory = (metadata->mask & FAN_ONDIR) != 0;
+
+        const auto directoryIt = directoriesByHandle.find(handleKey);
+
+        if (directoryIt == directoriesByHandle.end()) {
+            // the only events of interest outside the Applications directories concern themselves
+            const auto mountPointIt = mountPointsByHandle.find(handleKey);
+
+            if (mountPointIt == mountPointsByHandle.end() || !isDirectory || strcmp(name, "Applications") != 0)
+                return;
+
+            handleDirectoryEvent(metadata->mask, applicationsDirectory(mountPointIt.value()), events);
+            return;
+        }
+
+        // hidden files and directories are ignored, like by the inotify based watcher
+        if (name[0] == '.')
+            return;
+
+        const auto path = directoryIt.value() + "/" + QString::fromUtf8(name);
+
+        if (isDirectory) {
+            handleDirectoryEvent(metadata->mask, path, events);
+        } else if (metadata->mask & (FAN_CLOSE_WRITE | FAN_MOVED_TO)) {
+            events.push_back({Event::FILE_CHANGED, path});
+        } else if (metadata->mask & (FAN_DELETE | FAN_MOVED_FROM)) {
+            events.push_back({Event::FILE_REMOVED, path});
+        }
+    }
+
+    void handleDirectoryEvent(quint64 mask, const QString& path, std::vector<Event>& events) {
+        if (mask & (FAN_CREATE | FAN_MOVED_TO)) {
+            addTree(path);
+            events.push_back({Event::DIRECTORY_CREATED, path});
+        } else if (mask & (FAN_DELETE | FAN_MOVED_FROM)) {
+            removeTree(path);
+            events.push_back({Event::DIRECTORY_REMOVED, path});
+        }
+    }
+};
+
+FanotifyBackend::FanotifyBackend() : d(std::make_shared<PrivateData>()) {}
+
+std::shared_ptr<FanotifyBackend> FanotifyBackend::create() {
+    const auto fanotifyFd = fanotify_init(FAN_CLASS_NOTIF | FAN_REPORT_DFID_NAME | FAN_NONBLOCK | FAN_CLOEXEC,
+                                          O_RDONLY);
+
+    if (fanotifyFd < 0) {
+        const auto error = errno;
+        qDebug() << "fanotify not available:" << strerror(error);
+        return nullptr;
+    }
+
+    std::shared_ptr<FanotifyBackend> backend(new FanotifyBackend);
+    backend->d->fanotifyFd = fanotifyFd;
+
+    return backend;
+}
+
+int FanotifyBackend::fd() const {
+    return d->fanotifyFd;
+}
+
+bool FanotifyBackend::followMount(const QString& mountPoint) {
+    if (d->followedMountPoints.contains(mountPoint))
+        return true;
+
+    const auto rootKey = PrivateData::key(mountPoint);
+
+    if (rootKey.isEmpty()) {
+        std::cerr << "Could not determine file handle of " << mountPoint.toStdString() << std::endl;
+        return false;
+    }
+
+    if (fanotify_mark(d->fanotifyFd, FAN_MARK_ADD | FAN_MARK_FILESYSTEM, PrivateData::markMask, AT_FDCWD,
+                      mountPoint.toStdString().c_str()) != 0) {
+        const auto error = errno;
+        std::cerr << "Could not follow filesystem mounted at " << mountPoint.toStdString() << " with fanotify: "
+                  << strerror(error) << std::endl;
+        return false;
+    }
+
+    d->followedMountPoints.insert(mountPoint);
+    d->mountPointsByHandle.insert(rootKey, mountPoint);
+
+    const auto applicationsDirectoryPath = applicationsDirectory(mountPoint);
+
+    if (QDir(applicationsDirectoryPath).exists())
+        d->addTree(applicationsDirectoryPath);
+
+    return true;
+}
+
+void FanotifyBackend::unfollowMount(const QString& mountPoint) {
+    if (!d->followedMountPoints.remove(mountPoint))
+        return;
+
+    // the kernel removes the mark by itself when the filesystem is unmounted, so this may fail
+    fanotify_mark(d->fanotifyFd, FAN_MARK_REMOVE | FAN_MARK_FILESYSTEM, PrivateData::markMask, AT_FDCWD,
+                  mountPoint.toStdString().c_str());
+
+    auto it = d->mountPointsByHandle.begin();
+    while (it != d->mountPointsByHandle.end()) {
+        if (it.value() == mountPoint) {
+            it = d->mountPointsByHandle.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    d->removeTree(applicationsDirectory(mountPoint));
+}
+
+bool FanotifyBackend::isFollowed(const QString& applicationsDirectoryPath) const {
+    for (const auto& mountPoint : d->followedMountPoints) {
+        if (applicationsDirectory(mountPoint) == applicationsDirectoryPath)
+            return true;
+    }
+
+    return false;
+}
+
+std::vector<FanotifyBackend::Event> FanotifyBackend::readEvents() {
+    std::vector<Event> events;
+
+    while (true) {
+        const auto rv = read(d->fanotifyFd, d->readBuffer.data(), d->readBuffer.size());
+        const auto error = errno;
+
+        if (rv == -1) {
+            if (error == EAGAIN)
+                break;
+
+            if (error == EINTR)
+                continue;
+
+            std::cerr << "Failed to read from fanotify fd: " << strerror(error) << std::endl;
+            break;
+        }
+
+        auto length = static_cast<int>(rv);
+        auto* metadata = reinterpret_cast<const struct fanotify_event_metadata*>(d->readBuffer.data());
+
+        for (; FAN_EVENT_OK(metadata, length); metadata = FAN_EVENT_NEXT(metadata, length)) {
+            if (metadata->vers != FANOTIFY_METADATA_VERSION) {
+                std::cerr << "Unsupported fanotify metadata version " << metadata->vers << std::endl;
+                return events;
+            }
+
+            d->handleEvent(metadata, events);
+        }
+    }
+
+    return events;
+}
+
+#else
+
+// fanotify's filesystem marks or FAN_REPORT_DFID_NAME are not supported by the system this has been built on
+
+class FanotifyBackend::PrivateData {};
+
+FanotifyBackend::FanotifyBackend() = default;
+
+std::shared_ptr<FanotifyBackend> FanotifyBackend::create() {
+    return nullptr;
+}
+
+int FanotifyBackend::fd() const {
+    return -1;
+}
+
+bool FanotifyBackend::followMount(const QString&) {
+    return false;
+}
+
+void FanotifyBackend::unfollowMount(const QString&) {}
+
+bool FanotifyBackend::isFollowed(const QString&) const {
+    return false;
+}
+
+std::vector<FanotifyBackend::Event> FanotifyBackend::readEvents() {
+    return {};
+}
+
+#endif
+
+QString FanotifyBackend::applicationsDirectory(const QString& mountPoint) {
+    return QDir(mountPoint).absoluteFilePath("Applications");
+}
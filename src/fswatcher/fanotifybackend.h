@@ -0,0 +1,66 @@
+// system includes
+#include <memory>
+#include <vector>
+
+// library includes
+#include <QString>
+
+#pragma once
+
+/**
+ * Follows entire filesystems with a single fanotify mark each, and reports changes in their Applications directories.
+ *
+ * Unlike inotify watches, the marks don't need the directories to exist, so the creation of an Applications directory
+ * is noticed right away. Subdirectories don't need any additional resources either.
+ *
+ * Filesystem marks require CAP_SYS_ADMIN and Linux 5.9 or newer, which is why this backend is optional. The caller
+ * is expected to fall back to inotify if followMount(...) fails.
+ *
+ * As the kernel reports events for the entire filesystem, they're filtered by the file handles of the directories
+ * of interest. This way, no paths need to be resolved, which would require even more privileges.
+ */
+class FanotifyBackend {
+public:
+    struct Event {
+        enum Type {
+            FILE_CHANGED = 0,
+            FILE_REMOVED,
+            DIRECTORY_CREATED,
+            DIRECTORY_REMOVED,
+            // the kernel dropped events, all followed directories need to be checked again
+            EVENTS_LOST,
+        };
+
+        Type type;
+        QString path;
+    };
+
+private:
+    class PrivateData;
+    std::shared_ptr<PrivateData> d;
+
+    FanotifyBackend();
+
+public:
+    // returns nullptr if fanotify isn't available, either at build time or at runtime
+    static std::shared_ptr<FanotifyBackend> create();
+
+    // file descriptor to wait on for events
+    int fd() const;
+
+    // follows the filesystem mounted at mountPoint, and reports events in its Applications directory
+    // returns false if the filesystem can't be followed, e.g., due to missing privileges
+    bool followMount(const QString& mountPoint);
+
+    // stops following the filesystem mounted at mountPoint
+    void unfollowMount(const QString& mountPoint);
+
+    // path to the Applications directory of a mount point
+    static QString applicationsDirectory(const QString& mountPoint);
+
+    // checks whether the given directory is an Applications directory of a followed filesystem
+    bool isFollowed(const QString& applicationsDirectoryPath) const;
+
+    // reads all pending events
+    std::vector<Event> readEvents();
+};
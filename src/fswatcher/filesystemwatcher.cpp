@@ -1,4 +1,8 @@
 // system includes
+#include <cerrno>
+#include <cstring>
+#include <deque>
+#include <fstream>
 #include <iostream>
 #include <map>
 #include <unistd.h>
@@ -6,13 +10,18 @@
 // library includes
 #include <QDebug>
 #include <QDir>
+#include <QFileInfo>
 #include <QMutex>
-#include <QTimer>
+#include <QSet>
+#include <QSocketNotifier>
+#include <QStringList>
 #include <QThread>
+#include <QTimer>
 #include <sys/inotify.h>
 
 // local includes
 #include "filesystemwatcher.h"
+#include "fanotifybackend.h"
 
 class INotifyEvent {
 public:
@@ -23,6 +32,42 @@ public:
     INotifyEvent(uint32_t mask, QString path) : mask(mask), path(std::move(path)) {}
 };
 
+// splits the events into changed and removed files, in order to report them in batches
+// if a path has been changed as well as removed within the same batch, only the last event counts
+static void splitFileEvents(const std::vector<INotifyEvent>& events, uint32_t removalEvents,
+                            QStringList& changedFiles, QStringList& removedFiles) {
+    for (const auto& event : events) {
+        if (event.mask & removalEvents) {
+            removedFiles.append(event.path);
+        } else {
+            changedFiles.append(event.path);
+        }
+    }
+
+    // in the common case, all events are of the same kind, and there's nothing to sort out
+    if (changedFiles.empty() || removedFiles.empty())
+        return;
+
+    changedFiles.clear();
+    removedFiles.clear();
+
+    QSet<QString> seenPaths;
+    seenPaths.reserve(static_cast<int>(events.size()));
+
+    for (auto it = events.rbegin(); it != events.rend(); ++it) {
+        if (seenPaths.contains(it->path))
+            continue;
+
+        seenPaths.insert(it->path);
+
+        if (it->mask & removalEvents) {
+            removedFiles.prepend(it->path);
+        } else {
+            changedFiles.prepend(it->path);
+        }
+    }
+}
+
 class FileSystemWatcher::PrivateData {
 public:
     enum EVENT_TYPES {
@@ -30,122 +75,370 @@ public:
         fileChangeEvents = IN_CLOSE_WRITE | IN_MOVE,
         // events that indicate a file removal from a directory, e.g., deletion or moving to another location
         fileRemovalEvents = IN_DELETE | IN_MOVED_FROM,
+        // events that indicate a new subdirectory, which needs to be watched, too
+        directoryCreationEvents = IN_CREATE | IN_MOVED_TO,
     };
 
+    // share of the user's inotify watches we may use, the rest is left to other applications
+    static constexpr int WATCH_BUDGET_PERCENT = 50;
+
+    // used if the limit can't be determined, which is the kernel's default for systems with little memory
+    static constexpr int DEFAULT_MAX_USER_WATCHES = 8192;
+
+    // interval in which directories which couldn't be watched are checked for changes
+    static constexpr int UNWATCHED_CHECK_INTERVAL = 5 * 60 * 1000;
+
     // tracks whether the watcher is running
     bool isRunning;
 
 public:
+    // the directories to watch, including all their subdirectories
     QDirSet watchedDirectories;
-    QTimer eventsLoopTimer;
     QMutex* mutex;
 
+    // maximum number of watches this watcher sets up
+    const int watchBudget;
+
+    // directories which couldn't be watched because the budget was exhausted, including their subdirectories
+    QDirSet unwatchedDirectories;
+
+    // checks the unwatched directories regularly, and retries watching them
+    QTimer* unwatchedCheckTimer = nullptr;
+
+    // follows mounted filesystems, if available
+    // their Applications directories don't need any inotify watches then
+    std::shared_ptr<FanotifyBackend> fanotify;
+    QSocketNotifier* fanotifyNotifier = nullptr;
+    // set once following a filesystem failed, there's no point in trying again
+    bool fanotifyUnavailable = false;
+    QSet<QString> followedMountPoints;
+
+    // notifies us whenever the kernel has queued events on the inotify fd, so we only wake up when there's work to do
+    QSocketNotifier* eventsNotifier = nullptr;
+
+    // number of times we've been woken up to read events, and how many of those wakeups didn't yield any events
+    // with a readiness-driven reader, the latter should stay at (or very close to) zero
+    unsigned long wakeups = 0;
+    unsigned long idleWakeups = 0;
+
+    // number of events read from the inotify fd, and number of times the kernel's event queue overflowed
+    unsigned long eventsRead = 0;
+    unsigned long queueOverflows = 0;
+
 private:
+    struct Watch {
+        QDir directory;
+        // the directory's path including a trailing slash, built once so that the events' paths can be assembled
+        // with a single allocation
+        QString pathPrefix;
+    };
+
     int inotifyFd = -1;
-    std::map<int, QDir> watchFdMap;
+    std::map<int, Watch> watchFdMap;
+
+    // decoded events of the current read cycle, reused to avoid reallocations
+    std::vector<INotifyEvent> events;
+
+    // reused for every read to avoid reallocations
+    // large enough to hold a few hundred events, which reduces the amount of syscalls needed to drain the queue
+    std::vector<char> readBuffer = std::vector<char>(64 * 1024);
 
 public:
-    // reads events from the inotify fd and emits the correct signals
-    std::vector<INotifyEvent> readEventsFromFd() {
+    // reads all pending events from the inotify fd
+    // directories whose events might have been lost (e.g., because the kernel's event queue overflowed) are added to
+    // directoriesToRescan
+    // subdirectories which have been created or moved into a watched directory are watched, and added to newDirectories
+    // the returned buffer is valid until the next call
+    const std::vector<INotifyEvent>& readEventsFromFd(QDirSet& directoriesToRescan, QDirSet& newDirectories) {
         // we don't want to read events in parallel
         QMutexLocker lock{mutex};
 
-        // read raw bytes into buffer
-        // this is necessary, as the inotify_events have dynamic sizes
-        static const auto bufSize = 4096;
-        char buffer[bufSize] __attribute__ ((aligned(8)));
+        ++wakeups;
 
-        const auto rv = read(inotifyFd, buffer, bufSize);
-        const auto error = errno;
+        events.clear();
 
-        if (rv == 0) {
-            throw FileSystemWatcherError("read() on inotify FD must never return 0");
-        }
+        // drain the queue completely, otherwise the events keep piling up in the kernel until the queue overflows
+        while (true) {
+            // read raw bytes into buffer
+            // this is necessary, as the inotify_events have dynamic sizes
+            const auto rv = read(inotifyFd, readBuffer.data(), readBuffer.size());
+            const auto error = errno;
+
+            if (rv == 0) {
+                throw FileSystemWatcherError("read() on inotify FD must never return 0");
+            }
+
+            if (rv == -1) {
+                // we're using a non-blocking inotify fd, therefore, if errno is set to EAGAIN, there's no more events
+                // in the queue
+                if (error == EAGAIN)
+                    break;
 
-        if (rv == -1) {
-            // we're using a non-blocking inotify fd, therefore, if errno is set to EAGAIN, we just didn't find any
-            // new events
-            // this is not an error case
-            if (error == EAGAIN)
-                return {};
+                if (error == EINTR)
+                    continue;
 
-            throw FileSystemWatcherError(QString("Failed to read from inotify fd: ") + strerror(error));
-        }
+                throw FileSystemWatcherError(QString("Failed to read from inotify fd: ") + strerror(error));
+            }
+
+            for (char* p = readBuffer.data(); p < readBuffer.data() + rv;) {
+                // create inotify_event from current position in buffer
+                auto* currentEvent = (struct inotify_event*) p;
+
+                // update current position in buffer
+                p += sizeof(struct inotify_event) + currentEvent->len;
+
+                ++eventsRead;
+
+                // the kernel dropped events, and it doesn't tell us which watches were affected
+                // therefore, all directories need to be checked again
+                if (currentEvent->mask & IN_Q_OVERFLOW) {
+                    std::cerr << "Warning: inotify event queue overflowed, events have been lost" << std::endl;
+                    ++queueOverflows;
+
+                    // scans include subdirectories, so it's sufficient to rescan the top level directories
+                    for (const auto& directory : watchedDirectories) {
+                        directoriesToRescan.insert(directory);
+                    }
+
+                    continue;
+                }
+
+                const auto it = watchFdMap.find(currentEvent->wd);
+
+                // events for watches we've removed ourselves may still be in the queue
+                if (it == watchFdMap.end())
+                    continue;
+
+                // the kernel removed the watch (e.g., because the directory was deleted or the filesystem has been
+                // unmounted)
+                // we try to set up a new watch in case the directory still exists, and have it checked again, since
+                // we might have missed changes in the meantime
+                if (currentEvent->mask & IN_IGNORED) {
+                    const auto directory = it->second.directory;
 
-        // read events into vector
-        std::vector<INotifyEvent> events;
+                    watchFdMap.erase(it);
 
-        for (char* p = buffer; p < buffer + rv;) {
-            // create inotify_event from current position in buffer
-            auto* currentEvent = (struct inotify_event*) p;
+                    if (directory.exists()) {
+                        watchTrees({directory});
+                        directoriesToRescan.insert(directory);
+                    }
+
+                    continue;
+                }
+
+                const auto& watch = it->second;
+
+                if (currentEvent->mask & IN_ISDIR) {
+                    // hidden directories are neither watched nor scanned
+                    if (currentEvent->name[0] == '.')
+                        continue;
+
+                    const auto path = watch.pathPrefix + QString::fromUtf8(currentEvent->name);
+
+                    if (currentEvent->mask & directoryCreationEvents) {
+                        // files might have been created (or moved along with the directory) before the watch has
+                        // been set up, therefore the new directory needs to be scanned, too
+                        watchTrees({QDir(path)});
+                        newDirectories.insert(QDir(path));
+                    } else if (currentEvent->mask & IN_MOVED_FROM) {
+                        // unlike a deletion, moving a directory away doesn't remove its watches, but they'd report
+                        // wrong paths from now on
+                        // the AppImages in there can't be found under their old paths any more, therefore their
+                        // integration resources need to be cleaned up
+                        directoriesToRescan.insert(watch.directory);
+                        stopWatchingTree(QDir(path));
+                    }
+
+                    continue;
+                }
+
+                // e.g., files which have just been created, but not written to yet
+                if (!(currentEvent->mask & (fileChangeEvents | fileRemovalEvents)))
+                    continue;
 
-            // initialize new INotifyEvent with the data from the currentEvent
-            QString relativePath(currentEvent->name);
-            auto directory = watchFdMap[currentEvent->wd];
-            events.emplace_back(currentEvent->mask, directory.absolutePath() + "/" + relativePath);
+                QString path;
+                path.reserve(watch.pathPrefix.size() + static_cast<int>(strlen(currentEvent->name)));
+                path.append(watch.pathPrefix);
+                path.append(QString::fromUtf8(currentEvent->name));
 
-            // update current position in buffer
-            p += sizeof(struct inotify_event) + currentEvent->len;
+                events.emplace_back(currentEvent->mask, std::move(path));
+            }
         }
 
+        if (events.empty() && directoriesToRescan.empty() && newDirectories.empty())
+            ++idleWakeups;
+
         return events;
     }
 
-    PrivateData() : isRunning(false), watchedDirectories(), mutex(new QMutex) {
+    static int maxUserWatches() {
+        std::ifstream ifs("/proc/sys/fs/inotify/max_user_watches");
+
+        int value = 0;
+
+        if (!(ifs >> value) || value <= 0)
+            return DEFAULT_MAX_USER_WATCHES;
+
+        return value;
+    }
+
+    PrivateData() : isRunning(false),
+                    watchedDirectories(),
+                    mutex(new QMutex),
+                    watchBudget(std::max(1, static_cast<int>(maxUserWatches() * (WATCH_BUDGET_PERCENT / 100.0)))) {
         inotifyFd = inotify_init1(IN_NONBLOCK);
 
         if (inotifyFd < 0) {
             auto error = errno;
             throw FileSystemWatcherError(QString("Failed to initialize inotify, reason: ") + strerror(error));
         }
+
+        // the notifier stays disabled until the first watch has been set up
+        eventsNotifier = new QSocketNotifier(inotifyFd, QSocketNotifier::Read);
+        eventsNotifier->setEnabled(false);
     };
 
+    ~PrivateData() {
+        delete fanotifyNotifier;
+        delete unwatchedCheckTimer;
+        delete eventsNotifier;
+        close(inotifyFd);
+        delete mutex;
+    }
+
     // caution: method is not threadsafe!
-    bool startWatching(const QDir& directory) {
-        static const auto mask = fileChangeEvents | fileRemovalEvents;
+    int watchCount() const {
+        return static_cast<int>(watchFdMap.size());
+    }
 
-        qDebug() << "start watching directory " << directory;
+    static bool isInTree(const QString& path, const QString& rootPath) {
+        return path == rootPath || path.startsWith(rootPath + "/");
+    }
 
-        if (!directory.exists()) {
-            qDebug() << "Warning: directory " << directory.absolutePath() << " does not exist, skipping";
-            return true;
-        }
+    // caution: method is not threadsafe!
+    // returns false if the watch couldn't be set up, in that case, error is set to the errno value
+    bool startWatching(const QDir& directory, int& error) {
+        static const auto mask = fileChangeEvents | fileRemovalEvents | directoryCreationEvents;
+
+        qDebug() << "start watching directory " << directory;
 
         const int watchFd = inotify_add_watch(inotifyFd, directory.absolutePath().toStdString().c_str(), mask);
 
         if (watchFd == -1) {
-            const auto error = errno;
-            std::cerr << "Failed to start watching: " << strerror(error) << std::endl;
+            error = errno;
+            std::cerr << "Failed to start watching " << directory.absolutePath().toStdString() << ": "
+                      << strerror(error) << std::endl;
             return false;
         }
 
-        watchFdMap[watchFd] = directory;
-        eventsLoopTimer.start();
+        watchFdMap[watchFd] = Watch{directory, directory.absolutePath() + "/"};
+        eventsNotifier->setEnabled(true);
 
         return true;
     }
 
-    bool startWatching() {
-        QMutexLocker lock{mutex};
+    // caution: method is not threadsafe!
+    // watches the given directories and all their subdirectories, except for hidden ones
+    // the directories are traversed breadth first, so that, when the budget is exhausted, the shallow directories,
+    // which are most likely to be used to store AppImages, are watched, and the deeper ones are checked regularly
+    // returns false if a directory couldn't be watched for another reason
+    bool watchTrees(const QDirSet& roots) {
+        bool rv = true;
+
+        std::deque<QDir> queue(roots.begin(), roots.end());
+
+        while (!queue.empty()) {
+            const auto directory = queue.front();
+            queue.pop_front();
+
+            if (!directory.exists()) {
+                qDebug() << "Warning: directory " << directory.absolutePath() << " does not exist, skipping";
+                continue;
+            }
 
-        for (const auto& directory : watchedDirectories) {
-            if (!startWatching(directory))
-                return false;
+            if (fanotify != nullptr && fanotify->isFollowed(directory.absolutePath())) {
+                qDebug() << "Directory" << directory.absolutePath() << "is followed with fanotify";
+                continue;
+            }
+
+            if (watchCount() >= watchBudget) {
+                unwatchedDirectories.insert(directory);
+                continue;
+            }
+
+            int error = 0;
+
+            if (!startWatching(directory, error)) {
+                // the user's limit is shared with other applications, so it might be reached before our budget is
+                if (error == ENOSPC) {
+                    unwatchedDirectories.insert(directory);
+                    continue;
+                }
+
+                rv = false;
+                continue;
+            }
+
+            const auto subdirectoryNames = directory.entryList(QDir::Dirs | QDir::NoDotAndDotDot | QDir::NoSymLinks);
+
+            for (const auto& subdirectoryName : subdirectoryNames) {
+                queue.emplace_back(directory.absoluteFilePath(subdirectoryName));
+            }
         }
 
-        return true;
+        if (!unwatchedDirectories.empty()) {
+            std::cerr << "Warning: inotify watch budget (" << watchBudget << ") exhausted, checking "
+                      << unwatchedDirectories.size() << " directories regularly instead" << std::endl;
+
+            if (unwatchedCheckTimer != nullptr && !unwatchedCheckTimer->isActive())
+                unwatchedCheckTimer->start();
+        }
+
+        return rv;
     }
 
-    bool startWatching(const QDirSet& directories) {
-        QMutexLocker lock{mutex};
+    // caution: method is not threadsafe!
+    // removes the watches of the given directory and all its subdirectories
+    bool stopWatchingTree(const QDir& root) {
+        const auto rootPath = root.absolutePath();
 
-        for (const auto& directory : directories) {
-            if (!startWatching(directory)) {
-                return false;
+        bool rv = true;
+
+        // stopWatching(int) modifies the map, therefore we must not iterate over it while removing watches
+        std::vector<int> watchFds;
+
+        for (const auto& pair : watchFdMap) {
+            if (isInTree(pair.second.directory.absolutePath(), rootPath))
+                watchFds.push_back(pair.first);
+        }
+
+        for (const auto watchFd : watchFds) {
+            if (!stopWatching(watchFd))
+                rv = false;
+        }
+
+        auto it = unwatchedDirectories.begin();
+        while (it != unwatchedDirectories.end()) {
+            if (isInTree(it->absolutePath(), rootPath)) {
+                it = unwatchedDirectories.erase(it);
+            } else {
+                ++it;
             }
         }
 
-        return true;
+        return rv;
+    }
+
+    bool startWatching() {
+        QMutexLocker lock{mutex};
+
+        return watchTrees(watchedDirectories);
+    }
+
+    bool startWatching(const QDirSet& directories) {
+        QMutexLocker lock{mutex};
+
+        return watchTrees(directories);
     }
 
     // caution: method is not threadsafe!
@@ -177,34 +470,37 @@ public:
             }
         }
 
+        unwatchedDirectories.clear();
+        unwatchedCheckTimer->stop();
+
         return true;
     }
 
     bool stopWatching(const QDirSet& directories) {
         QMutexLocker lock{mutex};
 
-        for (const auto& directory : directories) {
-            for (const auto& pair : watchFdMap) {
-                if (pair.second == directory) {
-                    if (!stopWatching(pair.first)) {
-                        return false;
-                    }
-                }
-            }
+        bool rv = true;
 
-            // reaching the following line means that we couldn't find the requested path in the fd map
-            return false;
+        // if the directory isn't in the map, the kernel has removed the watch already (e.g., when the filesystem
+        // has been unmounted)
+        for (const auto& directory : directories) {
+            if (!stopWatchingTree(directory))
+                rv = false;
         }
 
-        return true;
+        return rv;
     }
 };
 
 FileSystemWatcher::FileSystemWatcher() {
     d = std::make_shared<PrivateData>();
 
-    d->eventsLoopTimer.setInterval(100);
-    connect(&d->eventsLoopTimer, &QTimer::timeout, this, &FileSystemWatcher::readEvents);
+    // QSocketNotifier::activated's signature differs between Qt versions, therefore we use the string based syntax
+    connect(d->eventsNotifier, SIGNAL(activated(int)), this, SLOT(readEvents()));
+
+    d->unwatchedCheckTimer = new QTimer;
+    d->unwatchedCheckTimer->setInterval(PrivateData::UNWATCHED_CHECK_INTERVAL);
+    connect(d->unwatchedCheckTimer, &QTimer::timeout, this, &FileSystemWatcher::checkUnwatchedDirectories);
 }
 
 FileSystemWatcher::FileSystemWatcher(const QDir& path) : FileSystemWatcher() {
@@ -262,25 +558,283 @@ bool FileSystemWatcher::stopWatching() {
             d->isRunning = false;
 
             // we can stop reporting events now, I guess
-            d->eventsLoopTimer.stop();
+            d->eventsNotifier->setEnabled(false);
+
+            if (d->fanotifyNotifier != nullptr)
+                d->fanotifyNotifier->setEnabled(false);
         }
     }
 
     return rv;
 }
 
+unsigned long FileSystemWatcher::wakeups() {
+    QMutexLocker lock{d->mutex};
+
+    return d->wakeups;
+}
+
+unsigned long FileSystemWatcher::idleWakeups() {
+    QMutexLocker lock{d->mutex};
+
+    return d->idleWakeups;
+}
+
+unsigned long FileSystemWatcher::eventsRead() {
+    QMutexLocker lock{d->mutex};
+
+    return d->eventsRead;
+}
+
+unsigned long FileSystemWatcher::queueOverflows() {
+    QMutexLocker lock{d->mutex};
+
+    return d->queueOverflows;
+}
+
+int FileSystemWatcher::watchCount() {
+    QMutexLocker lock{d->mutex};
+
+    return d->watchCount();
+}
+
+int FileSystemWatcher::watchBudget() {
+    return d->watchBudget;
+}
+
+int FileSystemWatcher::unwatchedDirectoryCount() {
+    QMutexLocker lock{d->mutex};
+
+    return static_cast<int>(d->unwatchedDirectories.size());
+}
+
 void FileSystemWatcher::readEvents() {
-    auto events = d->readEventsFromFd();
+    QDirSet directoriesToRescan;
+    QDirSet newDirectories;
 
-    for (const auto& event : events) {
-        const auto mask = event.mask;
+    QStringList changedFiles;
+    QStringList removedFiles;
+
+    {
+        const auto& events = d->readEventsFromFd(directoriesToRescan, newDirectories);
+
+        // IN_MOVED_FROM is part of both the change and the removal events, it must be reported as a removal
+        splitFileEvents(events, d->fileRemovalEvents, changedFiles, removedFiles);
+    }
 
-        if (mask & d->fileChangeEvents) {
-            emit fileChanged(event.path);
-        } else if (mask & d->fileRemovalEvents) {
-            emit fileRemoved(event.path);
+    // a single signal per read cycle and kind of event, instead of one per event
+    if (!changedFiles.empty())
+        emit filesChanged(changedFiles);
+
+    if (!removedFiles.empty())
+        emit filesRemoved(removedFiles);
+
+    if (!newDirectories.empty())
+        emit newDirectoriesToWatch(newDirectories);
+
+    if (!directoriesToRescan.empty())
+        emit directoriesNeedRescan(directoriesToRescan);
+}
+
+bool FileSystemWatcher::followMountedFilesystems(const QSet<QString>& mountPoints) {
+    QSet<QString> mountPointsToUnfollow;
+
+    {
+        QMutexLocker lock{d->mutex};
+
+        if (d->fanotifyUnavailable)
+            return false;
+
+        if (d->fanotify == nullptr) {
+            if (mountPoints.empty())
+                return true;
+
+            d->fanotify = FanotifyBackend::create();
+
+            if (d->fanotify == nullptr) {
+                d->fanotifyUnavailable = true;
+                return false;
+            }
+
+            d->fanotifyNotifier = new QSocketNotifier(d->fanotify->fd(), QSocketNotifier::Read);
+            connect(d->fanotifyNotifier, SIGNAL(activated(int)), this, SLOT(readFanotifyEvents()));
+        }
+
+        for (const auto& mountPoint : d->followedMountPoints) {
+            if (!mountPoints.contains(mountPoint))
+                mountPointsToUnfollow.insert(mountPoint);
+        }
+
+        for (const auto& mountPoint : mountPointsToUnfollow) {
+            d->fanotify->unfollowMount(mountPoint);
+            d->followedMountPoints.remove(mountPoint);
+        }
+
+        for (const auto& mountPoint : mountPoints) {
+            if (d->followedMountPoints.contains(mountPoint))
+                continue;
+
+            if (!d->fanotify->followMount(mountPoint)) {
+                // most likely, we lack the privileges, which applies to all filesystems
+                std::cerr << "Falling back to inotify for mounted filesystems" << std::endl;
+
+                for (const auto& followedMountPoint : d->followedMountPoints)
+                    d->fanotify->unfollowMount(followedMountPoint);
+
+                mountPointsToUnfollow += d->followedMountPoints;
+                d->followedMountPoints.clear();
+
+                delete d->fanotifyNotifier;
+                d->fanotifyNotifier = nullptr;
+                d->fanotify = nullptr;
+                d->fanotifyUnavailable = true;
+
+                break;
+            }
+
+            d->followedMountPoints.insert(mountPoint);
         }
     }
+
+    // the Applications directories of filesystems which are no longer followed need to be watched with inotify
+    // (if they still need to be watched at all)
+    QDirSet directoriesToWatch;
+
+    {
+        QMutexLocker lock{d->mutex};
+
+        if (!d->isRunning)
+            return !d->fanotifyUnavailable;
+
+        for (const auto& mountPoint : mountPointsToUnfollow) {
+            const QDir directory(FanotifyBackend::applicationsDirectory(mountPoint));
+
+            if (d->watchedDirectories.find(directory) != d->watchedDirectories.end())
+                directoriesToWatch.insert(directory);
+        }
+    }
+
+    d->startWatching(directoriesToWatch);
+
+    // inotify watches which were set up before are no longer needed
+    {
+        QMutexLocker lock{d->mutex};
+
+        for (const auto& mountPoint : d->followedMountPoints)
+            d->stopWatchingTree(QDir(FanotifyBackend::applicationsDirectory(mountPoint)));
+    }
+
+    return !d->fanotifyUnavailable;
+}
+
+void FileSystemWatcher::readFanotifyEvents() {
+    std::vector<FanotifyBackend::Event> events;
+
+    QDirSet newDirectories;
+    QDirSet disappearedDirectories;
+    QDirSet directoriesToRescan;
+
+    {
+        QMutexLocker lock{d->mutex};
+
+        if (d->fanotify == nullptr)
+            return;
+
+        ++d->wakeups;
+
+        events = d->fanotify->readEvents();
+        d->eventsRead += events.size();
+
+        if (events.empty())
+            ++d->idleWakeups;
+
+        for (const auto& event : events) {
+            const QDir directory(event.path);
+
+            switch (event.type) {
+                case FanotifyBackend::Event::DIRECTORY_CREATED: {
+                    // top level directories must be known for the following events, and for diffing on updates
+                    if (d->fanotify->isFollowed(event.path))
+                        d->watchedDirectories.insert(directory);
+
+                    newDirectories.insert(directory);
+                    break;
+                }
+                case FanotifyBackend::Event::DIRECTORY_REMOVED: {
+                    const auto it = d->watchedDirectories.find(directory);
+
+                    if (it != d->watchedDirectories.end()) {
+                        d->watchedDirectories.erase(it);
+                        disappearedDirectories.insert(directory);
+                    } else {
+                        directoriesToRescan.insert(QDir(QFileInfo(event.path).absolutePath()));
+                    }
+
+                    break;
+                }
+                case FanotifyBackend::Event::EVENTS_LOST: {
+                    ++d->queueOverflows;
+
+                    for (const auto& mountPoint : d->followedMountPoints)
+                        directoriesToRescan.insert(QDir(FanotifyBackend::applicationsDirectory(mountPoint)));
+
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+    }
+
+    std::vector<INotifyEvent> fileEvents;
+
+    for (const auto& event : events) {
+        if (event.type == FanotifyBackend::Event::FILE_CHANGED) {
+            fileEvents.emplace_back(IN_CLOSE_WRITE, event.path);
+        } else if (event.type == FanotifyBackend::Event::FILE_REMOVED) {
+            fileEvents.emplace_back(IN_DELETE, event.path);
+        }
+    }
+
+    QStringList changedFiles;
+    QStringList removedFiles;
+
+    splitFileEvents(fileEvents, d->fileRemovalEvents, changedFiles, removedFiles);
+
+    if (!changedFiles.empty())
+        emit filesChanged(changedFiles);
+
+    if (!removedFiles.empty())
+        emit filesRemoved(removedFiles);
+
+    if (!newDirectories.empty())
+        emit newDirectoriesToWatch(newDirectories);
+
+    if (!disappearedDirectories.empty())
+        emit directoriesToWatchDisappeared(disappearedDirectories);
+
+    if (!directoriesToRescan.empty())
+        emit directoriesNeedRescan(directoriesToRescan);
+}
+
+void FileSystemWatcher::checkUnwatchedDirectories() {
+    QDirSet unwatchedDirectories;
+
+    {
+        QMutexLocker lock{d->mutex};
+
+        std::swap(unwatchedDirectories, d->unwatchedDirectories);
+
+        // watches might have become available in the meantime, e.g., because other watched directories have been
+        // removed
+        d->watchTrees(unwatchedDirectories);
+
+        if (d->unwatchedDirectories.empty())
+            d->unwatchedCheckTimer->stop();
+    }
+
+    if (!unwatchedDirectories.empty())
+        emit unwatchedDirectoriesNeedCheck(unwatchedDirectories);
 }
 
 bool FileSystemWatcher::updateWatchedDirectories(QDirSet watchedDirectories) {
@@ -342,9 +896,8 @@ bool FileSystemWatcher::updateWatchedDirectories(QDirSet watchedDirectories) {
 
     // we must run both stop and start methods, so we cannot directly return false if either fails
     // also, this makes sure the signals are sent even in case either of the following methods fails
-    bool rv = true;
-    rv = rv && d->stopWatching(disappearedDirectories);
-    rv = rv && d->startWatching(newDirectories);
+    bool rv = d->stopWatching(disappearedDirectories);
+    rv = d->startWatching(newDirectories) && rv;
 
     // send out the signals for further handling by users of a fs watcher instance
     emit newDirectoriesToWatch(newDirectories);
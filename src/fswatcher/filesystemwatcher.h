@@ -8,6 +8,7 @@
 #include <QObject>
 #include <QSet>
 #include <QString>
+#include <QStringList>
 #include <QThread>
 
 // local includes
@@ -20,6 +21,15 @@ public:
     explicit FileSystemWatcherError(const QString& message) : std::runtime_error(message.toStdString().c_str()) {};
 };
 
+/**
+ * Watches directories and all their subdirectories (except for hidden ones) for AppImages being added or removed.
+ *
+ * Every directory requires an inotify watch, which are limited per user. When the watcher's share of them has been
+ * used up, the remaining directories are checked regularly instead.
+ *
+ * Optionally, the Applications directories of mounted filesystems can be followed with fanotify instead (see
+ * FanotifyBackend), which doesn't require any watches, and notices the creation of these directories.
+ */
 class FileSystemWatcher : public QObject {
     Q_OBJECT
 
@@ -38,12 +48,50 @@ public slots:
     void readEvents();
     bool updateWatchedDirectories(QDirSet watchedDirectories);
 
+    // follows the given mounted filesystems with fanotify, and stops following the ones not in the set any more
+    // their Applications directories are reported like watched directories, and don't need inotify watches
+    // returns false if fanotify can't be used, in that case the directories are watched with inotify as usual
+    bool followMountedFilesystems(const QSet<QString>& mountPoints);
+
+private slots:
+    void checkUnwatchedDirectories();
+    void readFanotifyEvents();
+
 public:
     QDirSet directories();
 
+    // number of times the watcher has been woken up to read events
+    unsigned long wakeups();
+
+    // number of wakeups which did not yield any events
+    unsigned long idleWakeups();
+
+    // number of events read from the kernel
+    unsigned long eventsRead();
+
+    // number of times the kernel dropped events because its queue was full
+    unsigned long queueOverflows();
+
+    // number of watches currently set up
+    int watchCount();
+
+    // maximum number of watches the watcher sets up
+    int watchBudget();
+
+    // number of directories (including their subdirectories) which couldn't be watched because the budget was exhausted
+    int unwatchedDirectoryCount();
+
 signals:
-    void fileChanged(QString path);
-    void fileRemoved(QString path);
+    // files which have been written to, or moved into a watched directory
+    // all events read at once are reported in a single batch
+    void filesChanged(QStringList paths);
+    // files which have been deleted, or moved out of a watched directory
+    void filesRemoved(QStringList paths);
+    // emitted for new directories to watch, and subdirectories created in (or moved into) watched directories
     void newDirectoriesToWatch(QDirSet set);
     void directoriesToWatchDisappeared(QDirSet set);
+    // emitted when events for these directories may have been lost, e.g., due to an inotify queue overflow
+    void directoriesNeedRescan(QDirSet set);
+    // emitted regularly for directories which couldn't be watched, they need to be checked for changes by other means
+    void unwatchedDirectoriesNeedCheck(QDirSet set);
 };
@@ -45,7 +45,7 @@ QString TranslationManager::getTranslationDir() {
     // first we need to find the translation directory
     // if this is run from the build tree, we try a path that can only work within the build directory
     // then, we try the expected install location relative to the main binary
-    const auto binaryDirPath = QApplication::applicationDirPath();
+    const auto binaryDirPath = QCoreApplication::applicationDirPath();
 
     // previously the path to the repo root dir was embedded to allow for finding the compiled translations
     // this lead to irreproducible builds
@@ -1,7 +1,7 @@
 #pragma once
 
 // library includes
-#include <QApplication>
+#include <QCoreApplication>
 #include <QTranslator>
 #include <QList>
 
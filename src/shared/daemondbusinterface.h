@@ -0,0 +1,7 @@
+#pragma once
+
+// names under which appimagelauncherd provides its D-Bus interface on the session bus
+// these are macros as Qt requires the interface name to be a string literal (see Q_CLASSINFO)
+#define APPIMAGELAUNCHERD_DBUS_SERVICE "org.appimage.AppImageLauncher.Daemon"
+#define APPIMAGELAUNCHERD_DBUS_PATH "/org/appimage/AppImageLauncher/Daemon"
+#define APPIMAGELAUNCHERD_DBUS_INTERFACE "org.appimage.AppImageLauncher.Daemon"
@@ -0,0 +1,180 @@
+// system headers
+#include <sys/stat.h>
+#include <time.h>
+extern "C" {
+    #include <glib.h>
+}
+
+// library headers
+#include <QDir>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStandardPaths>
+
+// local headers
+#include "desktopnameindex.h"
+
+// filesystems may stamp modification times with a coarse clock, which lags behind the system clock by up to a timer
+// tick, so changes made right after reading a file or directory can leave its mtime unchanged
+// therefore, what has been read is only trusted if the mtime is older than the time of reading by at least this margin
+static constexpr qint64 MTIME_GRANULARITY_NS = 20 * 1000000ll;
+
+class DesktopNameIndex::PrivateData {
+public:
+    struct File {
+        // -2 if the file has to be parsed again, as it may have changed within the same tick as it was parsed
+        qint64 mtimeNs;
+        // Name entry as found in the file
+        QString name;
+    };
+
+    struct Directory {
+        // -1 if the directory doesn't exist, -2 if it hasn't been read yet or has to be read again
+        qint64 mtimeNs = -2;
+        // keyed by path
+        std::map<QString, File> files;
+    };
+
+    QMutex mutex;
+
+    std::map<QString, Directory> directories;
+
+    // trimmed Name entries mapped to the paths and original Name entries of the files they're found in, sorted for
+    // prefix searches
+    std::multimap<QString, std::pair<QString, QString>> names;
+
+public:
+    static qint64 mTimeNs(const QString& path) {
+        struct stat st{};
+
+        if (stat(path.toStdString().c_str(), &st) != 0)
+            return -1;
+
+        return st.st_mtim.tv_sec * 1000000000ll + st.st_mtim.tv_nsec;
+    }
+
+    static qint64 nowNs() {
+        struct timespec ts{};
+        clock_gettime(CLOCK_REALTIME, &ts);
+
+        return ts.tv_sec * 1000000000ll + ts.tv_nsec;
+    }
+
+    // returns the mtime to remember for something read at the given time, or -2 if it must be read again, as later
+    // changes might not change its mtime (like git does with racily clean index entries)
+    static qint64 trustedMTimeNs(qint64 mtimeNs, qint64 readAtNs) {
+        return mtimeNs < readAtNs - MTIME_GRANULARITY_NS ? mtimeNs : -2;
+    }
+
+    // returns an empty string if the file isn't a valid desktop file
+    static QString readName(const QString& path) {
+        auto* keyFile = g_key_file_new();
+        QString name;
+
+        // if the key file parser can't load the file, it's most likely not a valid desktop file
+        if (g_key_file_load_from_file(keyFile, path.toStdString().c_str(), G_KEY_FILE_NONE, nullptr)) {
+            auto* nameEntry = g_key_file_get_string(keyFile, G_KEY_FILE_DESKTOP_GROUP, G_KEY_FILE_DESKTOP_KEY_NAME,
+                                                    nullptr);
+
+            if (nameEntry != nullptr) {
+                name = QString::fromUtf8(nameEntry);
+                g_free(nameEntry);
+            }
+        }
+
+        g_key_file_free(keyFile);
+
+        return name;
+    }
+
+    // re-reads the desktop files of the directory which have been modified since the last call
+    // returns true if the directory has changed
+    static bool update(const QString& dirPath, Directory& directory) {
+        const auto dirMTimeNs = mTimeNs(dirPath);
+
+        if (dirMTimeNs == directory.mtimeNs)
+            return false;
+
+        const auto readAtNs = nowNs();
+        directory.mtimeNs = trustedMTimeNs(dirMTimeNs, readAtNs);
+
+        std::map<QString, File> files;
+
+        const auto fileNames = QDir(dirPath).entryList({"*.desktop"}, QDir::Files);
+
+        for (const auto& fileName : fileNames) {
+            const auto path = QDir(dirPath).absoluteFilePath(fileName);
+            const auto fileMTimeNs = mTimeNs(path);
+
+            const auto previous = directory.files.find(path);
+
+            if (previous != directory.files.end() && previous->second.mtimeNs == fileMTimeNs) {
+                files.emplace(path, previous->second);
+                continue;
+            }
+
+            // invalid desktop files are recorded with an empty name as well, so they don't need to be parsed again
+            files.emplace(path, File{trustedMTimeNs(fileMTimeNs, readAtNs), readName(path)});
+        }
+
+        directory.files = std::move(files);
+
+        return true;
+    }
+
+    void rebuildNames() {
+        names.clear();
+
+        for (const auto& dirPair : directories) {
+            for (const auto& filePair : dirPair.second.files) {
+                if (filePair.second.name.isEmpty())
+                    continue;
+
+                names.emplace(filePair.second.name.trimmed(), std::make_pair(filePair.first, filePair.second.name));
+            }
+        }
+    }
+};
+
+DesktopNameIndex::DesktopNameIndex(const QStringList& directories) : d(std::make_shared<PrivateData>()) {
+    for (const auto& directory : directories) {
+        d->directories[QDir(directory).absolutePath()];
+    }
+}
+
+DesktopNameIndex& DesktopNameIndex::applicationsIndex() {
+    // default locations of desktop files on systems
+    static DesktopNameIndex index({
+        QString("/usr/share/applications"),
+        QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/applications"
+    });
+
+    return index;
+}
+
+std::map<std::string, std::string> DesktopNameIndex::findByNamePrefix(const QString& prefix) {
+    QMutexLocker lock(&d->mutex);
+
+    bool changed = false;
+
+    for (auto& pair : d->directories) {
+        if (PrivateData::update(pair.first, pair.second))
+            changed = true;
+    }
+
+    if (changed)
+        d->rebuildNames();
+
+    std::map<std::string, std::string> results;
+
+    const auto trimmedPrefix = prefix.trimmed();
+
+    for (auto it = d->names.lower_bound(trimmedPrefix); it != d->names.end(); ++it) {
+        if (!it->first.startsWith(trimmedPrefix))
+            break;
+
+        results[it->second.first.toStdString()] = it->second.second.toStdString();
+    }
+
+    return results;
+}
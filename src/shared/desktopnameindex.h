@@ -0,0 +1,38 @@
+#pragma once
+
+// system headers
+#include <map>
+#include <memory>
+#include <string>
+
+// library headers
+#include <QString>
+#include <QStringList>
+
+/**
+ * Index of the Name entries of the desktop files in a set of directories, used to detect name collisions.
+ *
+ * The desktop files are parsed once, and only parsed again when they have been modified. Directories are checked for
+ * changes by their modification time, which changes whenever files are added, removed or replaced (as done by
+ * GKeyFile and libappimage). Desktop files which are modified in place are not noticed until their directory
+ * changes. Directories and files whose mtime is too recent to rule out further changes within the same timer tick are
+ * read again on the next query.
+ *
+ * The index is thread safe.
+ */
+class DesktopNameIndex {
+private:
+    class PrivateData;
+    std::shared_ptr<PrivateData> d;
+
+public:
+    explicit DesktopNameIndex(const QStringList& directories);
+
+public:
+    // instance covering the system's and the user's applications directories
+    static DesktopNameIndex& applicationsIndex();
+
+    // returns the paths and Name entries of all desktop files whose Name entry starts with the given prefix
+    // leading and trailing whitespace is ignored
+    std::map<std::string, std::string> findByNamePrefix(const QString& prefix);
+};
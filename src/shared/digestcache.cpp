@@ -0,0 +1,249 @@
+// system headers
+#include <algorithm>
+#include <ctime>
+#include <iostream>
+#include <map>
+#include <sys/stat.h>
+#include <tuple>
+#include <vector>
+
+// library headers
+#include <QDataStream>
+#include <QFile>
+#include <QLockFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+
+// local headers
+#include "digestcache.h"
+#include "shared.h"
+
+// identifies the file format, must be changed whenever the format changes
+static const quint32 DIGEST_CACHE_MAGIC = 0x41494c44;
+static const quint32 DIGEST_CACHE_VERSION = 1;
+
+// once exceeded, the oldest entries are dropped, most of them will belong to files which don't exist any more
+static const size_t MAX_ENTRIES = 4096;
+
+class DigestCache::PrivateData {
+public:
+    // identifies a file in a specific state
+    struct Key {
+        quint64 device;
+        quint64 inode;
+        qint64 size;
+        qint64 mtimeNs;
+
+        bool operator<(const Key& other) const {
+            return std::tie(device, inode, size, mtimeNs) <
+                   std::tie(other.device, other.inode, other.size, other.mtimeNs);
+        }
+
+        bool operator==(const Key& other) const {
+            return std::tie(device, inode, size, mtimeNs) ==
+                   std::tie(other.device, other.inode, other.size, other.mtimeNs);
+        }
+    };
+
+    struct Entry {
+        QByteArray digest;
+        // seconds since the epoch, used to drop the oldest entries
+        qint64 storedAt;
+    };
+
+    const QString path;
+
+    mutable QMutex mutex;
+
+    bool loaded = false;
+    std::map<Key, Entry> entries;
+
+    quint64 hits = 0;
+    quint64 misses = 0;
+
+public:
+    explicit PrivateData(QString path) : path(std::move(path)) {}
+
+    static bool stat(const QString& path, Key& key) {
+        struct stat st{};
+
+        if (::stat(path.toStdString().c_str(), &st) != 0)
+            return false;
+
+        key = Key{
+            static_cast<quint64>(st.st_dev),
+            static_cast<quint64>(st.st_ino),
+            static_cast<qint64>(st.st_size),
+            st.st_mtim.tv_sec * 1000000000ll + st.st_mtim.tv_nsec,
+        };
+
+        return true;
+    }
+
+    // reads the entries stored in the file into the given map, entries which exist already are kept
+    bool read(std::map<Key, Entry>& target) const {
+        QFile file(path);
+
+        if (!file.open(QIODevice::ReadOnly))
+            return false;
+
+        QDataStream stream(&file);
+
+        quint32 magic = 0, version = 0, count = 0;
+        stream >> magic >> version;
+
+        if (magic != DIGEST_CACHE_MAGIC || version != DIGEST_CACHE_VERSION) {
+            std::cerr << "Warning: ignoring digest cache with unknown format" << std::endl;
+            return false;
+        }
+
+        stream >> count;
+
+        for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; ++i) {
+            Key key{};
+            Entry entry{};
+
+            stream >> key.device >> key.inode >> key.size >> key.mtimeNs >> entry.digest >> entry.storedAt;
+
+            if (stream.status() == QDataStream::Ok)
+                target.emplace(key, entry);
+        }
+
+        return stream.status() == QDataStream::Ok;
+    }
+
+    bool write(const std::map<Key, Entry>& source) const {
+        QSaveFile file(path);
+
+        if (!file.open(QIODevice::WriteOnly))
+            return false;
+
+        QDataStream stream(&file);
+
+        stream << DIGEST_CACHE_MAGIC << DIGEST_CACHE_VERSION << static_cast<quint32>(source.size());
+
+        for (const auto& pair : source) {
+            const auto& key = pair.first;
+            stream << key.device << key.inode << key.size << key.mtimeNs << pair.second.digest << pair.second.storedAt;
+        }
+
+        if (stream.status() != QDataStream::Ok) {
+            file.cancelWriting();
+            return false;
+        }
+
+        return file.commit();
+    }
+
+    // merges a new entry into the file, keeping the entries other processes have stored in the meantime
+    // must be called without holding the mutex, as it may take a while; the file itself is protected by a lock file
+    // returns false if the entry couldn't be stored, otherwise merged contains the file's new contents
+    bool store(const Key& key, const Entry& entry, std::map<Key, Entry>& merged) const {
+        QLockFile lockFile(path + ".lock");
+
+        // the cache is an optimization, and it's better to skip storing the entry than blocking for long
+        if (!lockFile.tryLock(5000)) {
+            std::cerr << "Warning: could not lock digest cache, not storing digest" << std::endl;
+            return false;
+        }
+
+        read(merged);
+
+        merged[key] = entry;
+
+        if (merged.size() > MAX_ENTRIES) {
+            // drop the oldest entries in one go
+            std::vector<std::pair<qint64, Key>> ages;
+            ages.reserve(merged.size());
+
+            for (const auto& pair : merged)
+                ages.emplace_back(pair.second.storedAt, pair.first);
+
+            const auto excess = merged.size() - MAX_ENTRIES;
+            std::nth_element(ages.begin(), ages.begin() + excess, ages.end());
+
+            for (size_t i = 0; i < excess; ++i)
+                merged.erase(ages[i].second);
+        }
+
+        if (!write(merged)) {
+            std::cerr << "Warning: could not write digest cache " << path.toStdString() << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+};
+
+DigestCache::DigestCache(QString path) : d(std::make_shared<PrivateData>(std::move(path))) {}
+
+QString DigestCache::defaultPath() {
+    return pathToCacheDirectory() + "/digests";
+}
+
+DigestCache& DigestCache::defaultCache() {
+    static DigestCache cache(defaultPath());
+    return cache;
+}
+
+QByteArray DigestCache::digest(const QString& path, const Calculator& calculate) {
+    PrivateData::Key key{};
+
+    if (!PrivateData::stat(path, key))
+        return {};
+
+    {
+        QMutexLocker lock(&d->mutex);
+
+        if (!d->loaded) {
+            d->read(d->entries);
+            d->loaded = true;
+        }
+
+        const auto it = d->entries.find(key);
+
+        if (it != d->entries.end()) {
+            ++d->hits;
+            return it->second.digest;
+        }
+
+        ++d->misses;
+    }
+
+    // the calculation may take very long, and must not block lookups of other files
+    QByteArray digest;
+
+    if (!calculate(path, digest))
+        return {};
+
+    // if the file has been modified while calculating the digest, the digest may belong to neither state
+    PrivateData::Key keyAfterCalculation{};
+
+    if (!PrivateData::stat(path, keyAfterCalculation) || !(keyAfterCalculation == key))
+        return digest;
+
+    const PrivateData::Entry entry{digest, static_cast<qint64>(time(nullptr))};
+    std::map<PrivateData::Key, PrivateData::Entry> merged;
+
+    if (d->store(key, entry, merged)) {
+        // lookups only need the mutex for swapping in the new entries
+        QMutexLocker lock(&d->mutex);
+        d->entries.swap(merged);
+    } else {
+        QMutexLocker lock(&d->mutex);
+        d->entries[key] = entry;
+    }
+
+    return digest;
+}
+
+quint64 DigestCache::hits() const {
+    QMutexLocker lock(&d->mutex);
+    return d->hits;
+}
+
+quint64 DigestCache::misses() const {
+    QMutexLocker lock(&d->mutex);
+    return d->misses;
+}
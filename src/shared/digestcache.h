@@ -0,0 +1,49 @@
+#pragma once
+
+// system headers
+#include <functional>
+#include <memory>
+
+// library headers
+#include <QByteArray>
+#include <QString>
+
+/**
+ * Persistent cache of the MD5 digests calculated for AppImages which don't have one embedded.
+ *
+ * Calculating the digest requires reading the entire file, which can be several gigabytes large. The cache stores the
+ * digests keyed by the file's device, inode, size and modification time, so that a file is only hashed again once it
+ * has been modified or replaced.
+ *
+ * The cache file is shared by all AppImageLauncher processes. Lookups are served from a copy loaded on first use;
+ * new digests are merged into the file while holding a lock, so that concurrent processes don't lose each other's
+ * entries.
+ *
+ * All methods are thread safe.
+ */
+class DigestCache {
+public:
+    // calculates the digest of the given file, returns false on errors
+    typedef std::function<bool(const QString& path, QByteArray& digest)> Calculator;
+
+private:
+    class PrivateData;
+    std::shared_ptr<PrivateData> d;
+
+public:
+    explicit DigestCache(QString path);
+
+public:
+    static QString defaultPath();
+
+    // instance stored at the default path, shared by the whole process
+    static DigestCache& defaultCache();
+
+    // returns the cached digest of the file, or calculates and caches it if there is none for its current state
+    // returns an empty byte array if the file can't be accessed or the calculation fails
+    QByteArray digest(const QString& path, const Calculator& calculate);
+
+    // lookups answered from the cache, and lookups which required calculating the digest, respectively
+    quint64 hits() const;
+    quint64 misses() const;
+};
@@ -0,0 +1,119 @@
+// system headers
+#include <iostream>
+
+// library headers
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+// local headers
+#include "integrationmanifest.h"
+
+// extensions libappimage may install icons with
+static const QStringList ICON_EXTENSIONS = {"png", "svg", "svgz", "xpm"};
+
+static QString pathToIntegrationManifest(const QString& digest) {
+    return pathToIntegrationManifestsDirectory() + "/" + digest + ".json";
+}
+
+// looks up the files installed for the AppImage by checking the locations libappimage uses directly, so that the
+// cost doesn't depend on how many other files there are
+static QStringList findInstalledFiles(const QString& digest, const QString& desktopFilePath,
+                                      const QString& iconName) {
+    const auto dataLocation = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation);
+
+    QStringList files{desktopFilePath};
+
+    if (!iconName.isEmpty()) {
+        const QDir hicolorDir(dataLocation + "/icons/hicolor");
+
+        // one directory per size, e.g., 48x48 or scalable
+        for (const auto& sizeDirName : hicolorDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+            for (const auto& extension : ICON_EXTENSIONS) {
+                const auto iconPath = hicolorDir.absolutePath() + "/" + sizeDirName + "/apps/" + iconName + "." +
+                                      extension;
+
+                if (QFile::exists(iconPath))
+                    files << iconPath;
+            }
+        }
+    }
+
+    const QDir mimePackagesDir(dataLocation + "/mime/packages");
+
+    for (const auto& fileName : mimePackagesDir.entryList({"appimagekit_" + digest + "*"}, QDir::Files)) {
+        files << mimePackagesDir.absoluteFilePath(fileName);
+    }
+
+    return files;
+}
+
+QString pathToIntegrationManifestsDirectory() {
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/appimagelauncher/manifests";
+}
+
+bool writeIntegrationManifest(const QString& digest, const QString& pathToAppImage, const QString& desktopFilePath,
+                              const QString& iconName) {
+    if (!QDir().mkpath(pathToIntegrationManifestsDirectory())) {
+        std::cerr << "[AppImageLauncher] Warning: "
+                  << "Could not create manifests directory " << pathToIntegrationManifestsDirectory().toStdString()
+                  << std::endl;
+        return false;
+    }
+
+    QJsonObject manifest;
+    manifest["appimage"] = pathToAppImage;
+    manifest["files"] = QJsonArray::fromStringList(findInstalledFiles(digest, desktopFilePath, iconName));
+
+    // the manifest must never be incomplete, otherwise files would be left behind on unintegration
+    QSaveFile file(pathToIntegrationManifest(digest));
+
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    file.write(QJsonDocument(manifest).toJson());
+
+    return file.commit();
+}
+
+bool hasIntegrationManifest(const QString& digest) {
+    return QFile::exists(pathToIntegrationManifest(digest));
+}
+
+bool removeIntegrationManifestFiles(const QString& digest, bool verbose) {
+    const auto manifestPath = pathToIntegrationManifest(digest);
+
+    QFile file(manifestPath);
+
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    const auto manifest = QJsonDocument::fromJson(file.readAll()).object();
+    file.close();
+
+    bool success = true;
+
+    for (const auto& value : manifest["files"].toArray()) {
+        const auto path = value.toString();
+
+        // files may have been removed by other tools in the meantime
+        if (!QFile::exists(path))
+            continue;
+
+        if (verbose)
+            std::cout << "Removing file: " << path.toStdString() << std::endl;
+
+        if (!QFile::remove(path))
+            success = false;
+    }
+
+    // keep the manifest if files are left, so the removal can be retried
+    if (success)
+        QFile::remove(manifestPath);
+
+    return success;
+}
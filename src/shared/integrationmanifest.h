@@ -0,0 +1,28 @@
+#pragma once
+
+// library headers
+#include <QString>
+
+/**
+ * Integration manifests record the files installed for an AppImage, i.e., the desktop file, the icons in all sizes and
+ * the MIME type definitions.
+ *
+ * They allow for removing exactly these files on unintegration and cleanup, without searching the data directories
+ * for them. AppImages integrated before manifests were introduced don't have one, and must be handled the old way.
+ *
+ * Manifests are named after the same digest of the AppImage's path libappimage uses to name the desktop files.
+ */
+
+// directory the manifests are stored in
+QString pathToIntegrationManifestsDirectory();
+
+// records the files installed for the AppImage with the given path digest, which is integrated with the given desktop
+// file and icon name
+bool writeIntegrationManifest(const QString& digest, const QString& pathToAppImage, const QString& desktopFilePath,
+                              const QString& iconName);
+
+bool hasIntegrationManifest(const QString& digest);
+
+// removes the files recorded in the manifest, and the manifest itself
+// returns false if there is no manifest or any of the files couldn't be removed
+bool removeIntegrationManifestFiles(const QString& digest, bool verbose = false);
@@ -0,0 +1,139 @@
+// system headers
+#include <sys/stat.h>
+#include <time.h>
+
+// library headers
+#include <QDir>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <appimage/appimage.h>
+
+// local headers
+#include "registereddesktopfiles.h"
+
+static const QString DESKTOP_FILE_PREFIX = "appimagekit_";
+
+// length of an MD5 digest in hexadecimal representation
+static constexpr int DIGEST_LENGTH = 32;
+
+// filesystems may stamp modification times with a coarse clock, which lags behind the system clock by up to a timer
+// tick, or even store whole seconds only (e.g., ext3), so files created right after a listing can leave the directory's
+// mtime unchanged
+// therefore, a listing is only trusted if the directory's mtime is older than the listing by at least this margin
+static constexpr qint64 MTIME_GRANULARITY_NS = 1000 * 1000000ll;
+
+class RegisteredDesktopFiles::PrivateData {
+public:
+    const QString applicationsDirectory;
+
+    QMutex mutex;
+
+    // -1 if the directory doesn't exist, -2 if it hasn't been listed yet or the listing can't be trusted
+    qint64 mtimeNs = -2;
+
+    // digests mapped to the paths of the desktop files
+    QHash<QString, QString> desktopFiles;
+
+public:
+    explicit PrivateData(QString applicationsDirectory) : applicationsDirectory(std::move(applicationsDirectory)) {}
+
+    static qint64 mTimeNs(const QString& path) {
+        struct stat st{};
+
+        if (stat(path.toStdString().c_str(), &st) != 0)
+            return -1;
+
+        return st.st_mtim.tv_sec * 1000000000ll + st.st_mtim.tv_nsec;
+    }
+
+    static qint64 nowNs() {
+        struct timespec ts{};
+        clock_gettime(CLOCK_REALTIME, &ts);
+
+        return ts.tv_sec * 1000000000ll + ts.tv_nsec;
+    }
+
+    // lists the directory if it has changed since the last listing
+    void update() {
+        const auto dirMTimeNs = mTimeNs(applicationsDirectory);
+
+        if (dirMTimeNs == mtimeNs)
+            return;
+
+        const auto listedAtNs = nowNs();
+
+        desktopFiles.clear();
+
+        const QDir directory(applicationsDirectory);
+
+        for (const auto& fileName : directory.entryList({DESKTOP_FILE_PREFIX + "*.desktop"}, QDir::Files)) {
+            const auto digest = desktopFileDigest(fileName);
+
+            if (digest.isEmpty())
+                continue;
+
+            desktopFiles.insert(digest, directory.absoluteFilePath(fileName));
+        }
+
+        // if the directory has been modified shortly before the listing, later modifications may not change
+        // its mtime, so it must be listed again on the next call (like git does with racily clean index entries)
+        mtimeNs = dirMTimeNs < listedAtNs - MTIME_GRANULARITY_NS ? dirMTimeNs : -2;
+    }
+};
+
+RegisteredDesktopFiles::RegisteredDesktopFiles(const QString& applicationsDirectory)
+    : d(std::make_shared<PrivateData>(applicationsDirectory)) {}
+
+RegisteredDesktopFiles& RegisteredDesktopFiles::userApplications() {
+    static RegisteredDesktopFiles instance(
+        QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/applications"
+    );
+
+    return instance;
+}
+
+QString RegisteredDesktopFiles::desktopFilePath(const QString& pathToAppImage) {
+    const auto digest = pathDigest(pathToAppImage);
+
+    if (digest.isEmpty())
+        return "";
+
+    QMutexLocker lock(&d->mutex);
+
+    d->update();
+
+    return d->desktopFiles.value(digest);
+}
+
+bool RegisteredDesktopFiles::isRegistered(const QString& pathToAppImage) {
+    return !desktopFilePath(pathToAppImage).isEmpty();
+}
+
+QString RegisteredDesktopFiles::pathDigest(const QString& pathToAppImage) {
+    auto* md5 = appimage_get_md5(pathToAppImage.toStdString().c_str());
+
+    if (md5 == nullptr)
+        return "";
+
+    QString rv(md5);
+    free(md5);
+
+    return rv;
+}
+
+QString RegisteredDesktopFiles::desktopFileDigest(const QString& desktopFilePath) {
+    const auto fileName = QFileInfo(desktopFilePath).fileName();
+
+    if (!fileName.startsWith(DESKTOP_FILE_PREFIX))
+        return "";
+
+    const auto digest = fileName.mid(DESKTOP_FILE_PREFIX.length(), DIGEST_LENGTH);
+
+    if (digest.length() != DIGEST_LENGTH)
+        return "";
+
+    return digest;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+// system headers
+#include <memory>
+
+// library headers
+#include <QString>
+
+/**
+ * Lookup of the desktop files libappimage has registered for AppImages.
+ *
+ * libappimage names these files appimagekit_<md5 of the AppImage's path>-<name>.desktop, and finds them by searching
+ * the applications directory every time it is asked. This class lists the directory once, and maps the digests to the
+ * desktop files, so that checking many AppImages doesn't require a directory listing each.
+ *
+ * The listing is repeated when the directory's modification time has changed, i.e., when desktop files have been
+ * added, removed or replaced, e.g., by an integration. As the modification time may not change for files created
+ * within the same timer tick, a listing is not trusted if the directory has been modified shortly before it.
+ *
+ * The lookup is thread safe.
+ */
+class RegisteredDesktopFiles {
+private:
+    class PrivateData;
+    std::shared_ptr<PrivateData> d;
+
+public:
+    explicit RegisteredDesktopFiles(const QString& applicationsDirectory);
+
+public:
+    // instance covering the user's applications directory, which libappimage registers the desktop files in
+    static RegisteredDesktopFiles& userApplications();
+
+    // returns the path to the desktop file registered for the given AppImage, or an empty string if there is none
+    QString desktopFilePath(const QString& pathToAppImage);
+
+    bool isRegistered(const QString& pathToAppImage);
+
+    // returns the digest of the AppImage's path libappimage names the desktop file after
+    static QString pathDigest(const QString& pathToAppImage);
+
+    // returns the digest contained in the name of a desktop file registered by libappimage, or an empty string if the
+    // name doesn't contain one
+    static QString desktopFileDigest(const QString& desktopFilePath);
+};
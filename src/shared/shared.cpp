@@ -1,46 +1,60 @@
 // system includes
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <sstream>
+#include <thread>
 #include <tuple>
+#include <vector>
 extern "C" {
     #include <appimage/appimage.h>
     #include <glib.h>
     // #include <libgen.h>
+    #include <spawn.h>
     #include <sys/stat.h>
+    #include <sys/wait.h>
     #include <stdio.h>
+    #include <time.h>
     #include <unistd.h>
 }
 
 // library includes
+#include <QCoreApplication>
+#include <QCryptographicHash>
 #include <QDebug>
-#include <QIcon>
-#include <QtDBus>
 #include <QDirIterator>
+#include <QElapsedTimer>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonParseError>
 #include <QLibraryInfo>
 #include <QMap>
 #include <QMapIterator>
-#include <QMessageBox>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QObject>
+#include <QProcess>
 #include <QRegularExpression>
 #include <QSet>
 #include <QSettings>
 #include <QStandardPaths>
-#include <QWindow>
-#include <QPushButton>
-#include <QPixmap>
 #ifdef ENABLE_UPDATE_HELPER
 #include <appimage/update.h>
 #endif
 
 // local headers
+#include "desktopfiletranslations.h"
+#include "desktopnameindex.h"
+#include "digestcache.h"
+#include "integrationmanifest.h"
+#include "registereddesktopfiles.h"
 #include "shared.h"
 #include "translationmanager.h"
 
+static MessageHandler messageHandler;
+static std::function<void()> iconsChangedHandler;
+
 static void gKeyFileDeleter(GKeyFile* ptr) {
     if (ptr != nullptr)
         g_key_file_free(ptr);
@@ -175,6 +189,9 @@ void createConfigFile(int askToMove,
         }
         file.write("\n");
     }
+
+    // number of AppImages the daemon integrates in parallel, defaults to the number of CPU cores
+    file.write("# integration_threads = 4\n");
 }
 
 
@@ -206,6 +223,32 @@ std::shared_ptr<QSettings> getConfig() {
     return rv;
 }
 
+static void displayMessage(MessageSeverity severity, const QString& message) {
+    if (messageHandler) {
+        messageHandler(severity, message);
+        return;
+    }
+
+    const auto title = severity == MESSAGE_ERROR ? QObject::tr("Error") : QObject::tr("Warning");
+    std::cerr << title.toStdString() << ": " << message.toStdString() << std::endl;
+}
+
+void displayError(const QString& message) {
+    displayMessage(MESSAGE_ERROR, message);
+}
+
+void displayWarning(const QString& message) {
+    displayMessage(MESSAGE_WARNING, message);
+}
+
+void setMessageHandler(MessageHandler handler) {
+    messageHandler = std::move(handler);
+}
+
+void setIconsChangedHandler(std::function<void()> handler) {
+    iconsChangedHandler = std::move(handler);
+}
+
 // TODO: check if this works with Wayland
 bool isHeadless() {
     bool isHeadless = true;
@@ -240,26 +283,6 @@ bool isHeadless() {
     return isHeadless;
 }
 
-// avoids code duplication, and works for both graphical and non-graphical environments
-void displayMessageBox(const QString& title, const QString& message, const QMessageBox::Icon icon) {
-    if (isHeadless()) {
-        std::cerr << title.toStdString() << ": " << message.toStdString() << std::endl;
-    } else {
-        // little complex, can't use QMessageBox::{critical,warning,...} for the same reason as in main()
-        auto* mb = new QMessageBox(icon, title, message, QMessageBox::Ok, nullptr);
-        mb->show();
-        QApplication::exec();
-    }
-}
-
-void displayError(const QString& message) {
-    displayMessageBox(QObject::tr("Error"), message, QMessageBox::Critical);
-}
-
-void displayWarning(const QString& message) {
-    displayMessageBox(QObject::tr("Warning"), message, QMessageBox::Warning);
-}
-
 QDir integratedAppImagesDestination() {
     auto config = getConfig();
 
@@ -327,14 +350,8 @@ QList<Mount> listMounts() {
     return mountedDirectories;
 }
 
-QSet<QString> additionalAppImagesLocations(const bool includeAllMountPoints) {
-    QSet<QString> additionalLocations;
-
-    additionalLocations << "/Applications";
-
-    // integrate AppImages from mounted filesystems, if requested
+bool isAppImagesLocationMount(const QString& device, const QString& mountPoint, const QString& fsType) {
     // we don't want to read files from any FUSE mounted filesystems nor from any virtual filesystems
-    // to
     static const auto validFilesystems = {"ext2", "ext3", "ext4", "ntfs", "vfat"};
 
     static const auto blacklistedMountPointPrefixes = {
@@ -346,45 +363,57 @@ QSet<QString> additionalAppImagesLocations(const bool includeAllMountPoints) {
         "/snap",
     };
 
-    if (includeAllMountPoints) {
-        for (const auto& mount : listMounts()) {
-            const auto& device = mount.getDevice();
-            const auto& mountPoint = mount.getMountPoint();
-            const auto& fsType = mount.getFsType();
+    // we have to filter out virtual filesystems, i.e., ones which have a "nonsense" device path
+    // any device that doesn't start with / is likely virtual, this is the first indicator
+    if (device.size() < 1 || device[0] != '/') {
+        return false;
+    }
 
-            // we have to filter out virtual filesystems, i.e., ones which have a "nonsense" device path
-            // any device that doesn't start with / is likely virtual, this is the first indicator
-            if (device.size() < 1 || device[0] != '/') {
-                continue;
-            }
+    // the device should exist for obvious reasons
+    if (!QFileInfo(QFileInfo(device).absoluteFilePath()).exists()) {
+        return false;
+    }
 
-            // the device should exist for obvious reasons
-            if (!QFileInfo(QFileInfo(device).absoluteFilePath()).exists()) {
-                continue;
-            }
+    // we don't want to mount any loop-mounted or bind-mounted or other devices, only... "native" ones
+    // therefore we permit only "real" devices listed within /dev
+    if (!device.startsWith("/dev/")) {
+        return false;
+    }
 
-            // we don't want to mount any loop-mounted or bind-mounted or other devices, only... "native" ones
-            // therefore we permit only "real" devices listed within /dev
-            if (!device.startsWith("/dev/")) {
-                continue;
-            }
+    // there's a few locations which we know we don't want to search for AppImages in
+    // either it's a waste of time or otherwise a bad idea, but it will surely save time *not* to search them
+    if (std::find_if(blacklistedMountPointPrefixes.begin(), blacklistedMountPointPrefixes.end(),
+                     [&mountPoint](const QString& prefix) {
+                         return mountPoint == prefix || mountPoint.startsWith(prefix + "/");
+                     }) != blacklistedMountPointPrefixes.end()) {
+        return false;
+    }
 
-            // there's a few locations which we know we don't want to search for AppImages in
-            // either it's a waste of time or otherwise a bad idea, but it will surely save time *not* to search them
-            if (std::find_if(blacklistedMountPointPrefixes.begin(), blacklistedMountPointPrefixes.end(),
-                             [&mountPoint](const QString& prefix) {
-                                 return mountPoint == prefix || mountPoint.startsWith(prefix + "/");
-                             }) != blacklistedMountPointPrefixes.end()) {
-                continue;
-            }
+    // the root mount point's Applications directory is always included anyway
+    if (mountPoint == "/") {
+        return false;
+    }
 
-            // we can skip the root mount point, as we handled it above
-            if (mountPoint == "/") {
-                continue;
-            }
+    // we only support a limited set of filesystems
+    if (std::find(validFilesystems.begin(), validFilesystems.end(), fsType) == validFilesystems.end()) {
+        return false;
+    }
 
-            // we only support a limited set of filesystems
-            if (std::find(validFilesystems.begin(), validFilesystems.end(), fsType) == validFilesystems.end()) {
+    return true;
+}
+
+QSet<QString> additionalAppImagesLocations(const bool includeAllMountPoints) {
+    QSet<QString> additionalLocations;
+
+    additionalLocations << "/Applications";
+
+    // integrate AppImages from mounted filesystems, if requested
+    if (includeAllMountPoints) {
+        for (const auto& mount : listMounts()) {
+            const auto& device = mount.getDevice();
+            const auto& mountPoint = mount.getMountPoint();
+
+            if (!isAppImagesLocationMount(device, mountPoint, mount.getFsType())) {
                 continue;
             }
 
@@ -514,62 +543,227 @@ QString buildPathToIntegratedAppImage(const QString& pathToAppImage) {
 }
 
 std::map<std::string, std::string> findCollisions(const QString& currentNameEntry) {
-    std::map<std::string, std::string> collisions{};
+    // the desktop files are only parsed again when they change, so this is cheap to call once per integration
+    return DesktopNameIndex::applicationsIndex().findByNamePrefix(currentNameEntry);
+}
 
-    // default locations of desktop files on systems
-    const auto directories = {
-        QString("/usr/share/applications/"),
-        QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/applications/"
-    };
+// the tools updating the caches of a single category of files
+// the tools within a group are run one after another, while the groups are independent of each other
+struct CacheUpdateToolGroup {
+    DesktopCacheCategory category;
+    std::vector<std::vector<std::string>> commands;
+};
 
-    for (const auto& directory : directories) {
-        QDirIterator iterator(directory, QDirIterator::FollowSymlinks);
+// adds the name, size and modification time of every file in the directory matching the filters to the hash
+static void addFilesToStamp(QCryptographicHash& hash, const QString& dirPath, const QStringList& nameFilters) {
+    // entries are sorted by name, so the result doesn't depend on the order in which the files were created
+    for (const auto& fileName : QDir(dirPath).entryList(nameFilters, QDir::Files)) {
+        const auto path = dirPath + "/" + fileName;
 
-        while (iterator.hasNext()) {
-            const auto filename = iterator.next();
+        struct stat st{};
 
-            if (!QFileInfo(filename).isFile() || !filename.endsWith(".desktop"))
-                continue;
+        if (stat(path.toStdString().c_str(), &st) != 0)
+            continue;
 
-            std::shared_ptr<GKeyFile> desktopFile(g_key_file_new(), gKeyFileDeleter);
-            std::shared_ptr<GError*> error(nullptr, gErrorDeleter);
+        const auto entry = path + "\t" + QString::number(st.st_size) + "\t" +
+                           QString::number(st.st_mtim.tv_sec * 1000000000ll + st.st_mtim.tv_nsec) + "\n";
+        hash.addData(entry.toUtf8());
+    }
+}
 
-            // if the key file parser can't load the file, it's most likely not a valid desktop file, so we just skip this file
-            if (!g_key_file_load_from_file(desktopFile.get(), filename.toStdString().c_str(), G_KEY_FILE_KEEP_TRANSLATIONS, error.get()))
-                continue;
+// adds the modification time of the directory to the hash, which changes whenever files are added, removed or renamed
+// in there
+// files created within the same timer tick as a recent modification may leave the mtime unchanged, therefore the
+// current time is added as well for directories modified within the last second, so that the next stamp differs
+static void addDirectoryToStamp(QCryptographicHash& hash, const QString& dirPath) {
+    struct stat st{};
 
-            auto* nameEntry = g_key_file_get_string(desktopFile.get(), G_KEY_FILE_DESKTOP_GROUP, G_KEY_FILE_DESKTOP_KEY_NAME, error.get());
+    if (stat(dirPath.toStdString().c_str(), &st) != 0)
+        return;
 
-            // invalid desktop file, needs to be skipped
-            if (nameEntry == nullptr)
-                continue;
+    const auto mtimeNs = st.st_mtim.tv_sec * 1000000000ll + st.st_mtim.tv_nsec;
+
+    struct timespec now{};
+    clock_gettime(CLOCK_REALTIME, &now);
+    const auto nowNs = now.tv_sec * 1000000000ll + now.tv_nsec;
+
+    auto entry = dirPath + "\t" + QString::number(mtimeNs);
+
+    if (mtimeNs >= nowNs - 1000000000ll)
+        entry += "\t" + QString::number(nowNs);
+
+    hash.addData((entry + "\n").toUtf8());
+}
 
-            if (QString(nameEntry).trimmed().startsWith(currentNameEntry.trimmed())) {
-                collisions[filename.toStdString()] = nameEntry;
+// calculates a value which changes whenever files of the given category are added, removed or modified
+// the values are compared to the ones calculated before the caches have been updated the last time, therefore the
+// files the tools write themselves must not be taken into account (e.g., icon-theme.cache, mimeinfo.cache)
+static QByteArray cacheCategoryStamp(DesktopCacheCategory category, const QString& dataLocation) {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+
+    switch (category) {
+        case DESKTOP_FILES_CACHE: {
+            // update-desktop-database writes mimeinfo.cache into the same directory
+            addFilesToStamp(hash, dataLocation + "/applications", {"*.desktop"});
+            break;
+        }
+        case ICONS_CACHE: {
+            // icons are installed into hicolor/<size>/<context>/, the cache files are located in hicolor/ directly
+            // there are many icons per AppImage, so the directories are looked at rather than the icons themselves
+            // the cache only records which icons exist, so icons replaced in place don't require an update anyway
+            QDir hicolorDir(dataLocation + "/icons/hicolor");
+
+            for (const auto& sizeDir : hicolorDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+                QDir contextsDir(hicolorDir.filePath(sizeDir));
+                addDirectoryToStamp(hash, contextsDir.path());
+
+                for (const auto& contextDir : contextsDir.entryList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+                    addDirectoryToStamp(hash, contextsDir.filePath(contextDir));
+                }
             }
+
+            break;
+        }
+        case MIME_TYPES_CACHE: {
+            // libappimage installs the package files only, the rest of the directory is generated by the tool
+            addFilesToStamp(hash, dataLocation + "/mime/packages", {"*.xml"});
+            break;
         }
+        default:
+            return {};
     }
 
-    return collisions;
+    return hash.result();
 }
 
-bool updateDesktopDatabaseAndIconCaches() {
+// runs a tool directly (i.e., without a shell) and waits for it to finish
+// returns the tool's exit code, or -1 if it could not be run
+static int runTool(const std::string& path, const std::vector<std::string>& arguments) {
+    std::vector<char*> argv;
+    argv.reserve(arguments.size() + 2);
+
+    argv.push_back(const_cast<char*>(path.c_str()));
+    for (const auto& argument : arguments)
+        argv.push_back(const_cast<char*>(argument.c_str()));
+    argv.push_back(nullptr);
+
+    pid_t pid;
+
+    if (posix_spawn(&pid, path.c_str(), nullptr, nullptr, argv.data(), environ) != 0)
+        return -1;
+
+    int status = 0;
+
+    while (waitpid(pid, &status, 0) == -1) {
+        if (errno != EINTR)
+            return -1;
+    }
+
+    if (!WIFEXITED(status))
+        return -1;
+
+    return WEXITSTATUS(status);
+}
+
+bool updateDesktopDatabaseAndIconCaches(int categories) {
     const auto dataLocation = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation);
 
-    const std::map<std::string, std::string> commands = {
-        {"update-desktop-database", dataLocation.toStdString() + "/applications"},
-        {"gtk-update-icon-cache-3.0", dataLocation.toStdString() + "/icons/hicolor/ -t"},
-        {"gtk-update-icon-cache", dataLocation.toStdString() + "/icons/hicolor/ -t"},
-        {"xdg-desktop-menu", "forceupdate"},
-        {"update-mime-database", dataLocation.toStdString() + "/mime "},
-        {"update-icon-caches", dataLocation.toStdString() + "/icons/"},
+    // the first element of every command is the tool's name, the rest are the arguments
+    const std::vector<CacheUpdateToolGroup> groups = {
+        {DESKTOP_FILES_CACHE, {
+            {"update-desktop-database", dataLocation.toStdString() + "/applications"},
+            {"xdg-desktop-menu", "forceupdate"},
+        }},
+        {ICONS_CACHE, {
+            {"gtk-update-icon-cache-3.0", dataLocation.toStdString() + "/icons/hicolor/", "-t"},
+            {"gtk-update-icon-cache", dataLocation.toStdString() + "/icons/hicolor/", "-t"},
+            {"update-icon-caches", dataLocation.toStdString() + "/icons/"},
+        }},
+        {MIME_TYPES_CACHE, {
+            {"update-mime-database", dataLocation.toStdString() + "/mime"},
+        }},
+    };
+
+    // the tools are looked up only once per process
+    // the paths are empty for tools which are not available on this system
+    static const auto toolPaths = []() {
+        std::map<std::string, std::string> paths;
+
+        for (const auto& name : {"update-desktop-database", "xdg-desktop-menu", "gtk-update-icon-cache-3.0",
+                                 "gtk-update-icon-cache", "update-icon-caches", "update-mime-database"}) {
+            paths[name] = QStandardPaths::findExecutable(name).toStdString();
+        }
+
+        return paths;
+    }();
+
+    // stamps of the file categories after the last update
+    // the caches might be updated concurrently by multiple threads, therefore the state must be guarded
+    static QMutex stampsMutex;
+    static std::map<DesktopCacheCategory, QByteArray> lastStamps;
+
+    struct ToolResult {
+        std::string name;
+        int exitCode;
+        qint64 durationMs;
     };
 
-    for (const auto& command : commands) {
-        // only call if the command exists
-        if (system(("which " + command.first + " 2>&1 1>/dev/null").c_str()) == 0) {
-            // exit codes are not evaluated intentionally
-            system((command.first + " " + command.second).c_str());
+    std::vector<std::vector<ToolResult>> results(groups.size());
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < groups.size(); ++i) {
+        const auto& group = groups[i];
+
+        if (!(categories & group.category))
+            continue;
+
+        // the stamp is calculated before running the tools, so that files changed while they're running cause another
+        // update next time
+        const auto stamp = cacheCategoryStamp(group.category, dataLocation);
+
+        {
+            QMutexLocker lock(&stampsMutex);
+
+            const auto lastStamp = lastStamps.find(group.category);
+
+            if (lastStamp != lastStamps.end() && lastStamp->second == stamp)
+                continue;
+        }
+
+        // the groups are independent of each other, therefore they're run in parallel
+        threads.emplace_back([&group, &results, i, stamp]() {
+            for (const auto& command : group.commands) {
+                const auto& toolPath = toolPaths.at(command.front());
+
+                // only call if the command exists
+                if (toolPath.empty())
+                    continue;
+
+                QElapsedTimer timer;
+                timer.start();
+
+                // exit codes are not evaluated intentionally
+                const auto exitCode = runTool(toolPath, std::vector<std::string>(command.begin() + 1, command.end()));
+
+                results[i].push_back({command.front(), exitCode, timer.elapsed()});
+            }
+
+            QMutexLocker lock(&stampsMutex);
+            lastStamps[group.category] = stamp;
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    for (const auto& groupResults : results) {
+        for (const auto& result : groupResults) {
+            std::cout << "Ran " << result.name << " in " << result.durationMs << " ms";
+
+            if (result.exitCode != 0)
+                std::cout << " (exit code " << result.exitCode << ")";
+
+            std::cout << std::endl;
         }
     }
 
@@ -615,16 +809,100 @@ QString privateLibDirPath(const QString& srcSubdirName) {
 }
 #endif
 
-bool installDesktopFileAndIcons(const QString& pathToAppImage, bool resolveCollisions) {
+// translations of the names of the desktop actions, keyed by locale
+struct DesktopActionTranslations {
+    QMap<QString, QString> removeActionNames;
+    QMap<QString, QString> updateActionNames;
+};
+
+static DesktopActionTranslations loadDesktopActionTranslations() {
+    DesktopActionTranslations translations;
+
+    // the translations are compiled in from i18n/desktopfiles.*.json
+    for (const auto& entry : DESKTOP_FILE_TRANSLATIONS) {
+        if (entry.removeActionName != nullptr)
+            translations.removeActionNames[entry.locale] = QString::fromUtf8(entry.removeActionName);
+        if (entry.updateActionName != nullptr)
+            translations.updateActionNames[entry.locale] = QString::fromUtf8(entry.updateActionName);
+    }
+
+    // JSON files in the translation directory override the built-in translations, e.g., for testing new translations
+    // without rebuilding
+    QDirIterator i18nDirIterator(TranslationManager::getTranslationDir(), {"desktopfiles.*.json"}, QDir::Files);
+
+    while (i18nDirIterator.hasNext()) {
+        const auto& filePath = i18nDirIterator.next();
+        const auto& fileName = QFileInfo(filePath).fileName();
+
+        // check whether filename's format is alright, otherwise parsing the locale might try to access a
+        // non-existing (or the wrong) member
+        auto splitFilename = fileName.split(".");
+
+        if (splitFilename.size() != 3)
+            continue;
+
+        // parse locale from filename
+        auto locale = splitFilename[1];
+
+        QFile jsonFile(filePath);
+
+        if (!jsonFile.open(QIODevice::ReadOnly)) {
+            displayWarning(QCoreApplication::translate("QMessageBox", "Could not parse desktop file translations:\nCould not open file for reading:\n\n%1").arg(fileName));
+            continue;
+        }
+
+        // TODO: need to make sure that this doesn't try to read huge files at once
+        auto data = jsonFile.readAll();
+
+        QJsonParseError parseError{};
+        auto jsonDoc = QJsonDocument::fromJson(data, &parseError);
+
+        // show warning on syntax errors and continue
+        if (parseError.error != QJsonParseError::NoError || jsonDoc.isNull() || !jsonDoc.isObject()) {
+            displayWarning(QCoreApplication::translate("QMessageBox", "Could not parse desktop file translations:\nInvalid syntax:\n\n%1").arg(parseError.errorString()));
+            continue;
+        }
+
+        auto jsonObj = jsonDoc.object();
+
+        for (const auto& key : jsonObj.keys()) {
+            auto value = jsonObj[key].toString();
+
+            if (key.startsWith("Desktop Action update")) {
+                translations.updateActionNames[locale] = value;
+            } else if (key.startsWith("Desktop Action remove")) {
+                translations.removeActionNames[locale] = value;
+            }
+        }
+    }
+
+    return translations;
+}
+
+// the translations are needed for every integration, but loaded only once per process
+static const DesktopActionTranslations& desktopActionTranslations() {
+    static const DesktopActionTranslations translations = loadDesktopActionTranslations();
+    return translations;
+}
+
+bool installDesktopFileAndIcons(const QString& pathToAppImage, bool resolveCollisions,
+                                DesktopIntegrationTimings* timings) {
+    QElapsedTimer timer;
+    timer.start();
+
     if (appimage_register_in_system(pathToAppImage.toStdString().c_str(), false) != 0) {
         displayError(QObject::tr("Failed to register AppImage in system via libappimage"));
         return false;
     }
 
-    const auto* desktopFilePath = appimage_registered_desktop_file_path(pathToAppImage.toStdString().c_str(), nullptr, false);
+    if (timings != nullptr)
+        timings->registerMs = timer.restart();
 
-    // sanity check -- if the file doesn't exist, the function returns NULL
-    if (desktopFilePath == nullptr) {
+    const auto desktopFilePathStr = RegisteredDesktopFiles::userApplications().desktopFilePath(pathToAppImage).toStdString();
+    const auto* desktopFilePath = desktopFilePathStr.c_str();
+
+    // sanity check -- if the file doesn't exist, an empty path is returned
+    if (desktopFilePathStr.empty()) {
         displayError(QObject::tr("Failed to find integrated desktop file"));
         return false;
     }
@@ -671,7 +949,7 @@ bool installDesktopFileAndIcons(const QString& pathToAppImage, bool resolveColli
         auto collisions = findCollisions(nameEntry);
 
         // make sure to remove own entry
-        collisions.erase(collisions.find(desktopFilePath));
+        collisions.erase(desktopFilePath);
 
         if (!collisions.empty()) {
             // collisions are resolved like in the filesystem: a monotonically increasing number in brackets is
@@ -723,66 +1001,7 @@ bool installDesktopFileAndIcons(const QString& pathToAppImage, bool resolveColli
 
     std::vector<std::string> desktopActions = {"Remove"};
 
-    // load translations from JSON file(s)
-    QMap<QString, QString> removeActionNameTranslations;
-
-#ifdef ENABLE_UPDATE_HELPER
-    QMap<QString, QString> updateActionNameTranslations;
-
-    {
-        QDirIterator i18nDirIterator(TranslationManager::getTranslationDir());
-
-        while(i18nDirIterator.hasNext()) {
-            const auto& filePath = i18nDirIterator.next();
-            const auto& fileName = QFileInfo(filePath).fileName();
-
-            if (!QFileInfo(filePath).isFile() || !(fileName.startsWith("desktopfiles.") && fileName.endsWith(".json")))
-                continue;
-
-            // check whether filename's format is alright, otherwise parsing the locale might try to access a
-            // non-existing (or the wrong) member
-            auto splitFilename = fileName.split(".");
-
-            if (splitFilename.size() != 3)
-                continue;
-
-            // parse locale from filename
-            auto locale = splitFilename[1];
-
-            QFile jsonFile(filePath);
-
-            if (!jsonFile.open(QIODevice::ReadOnly)) {
-                displayWarning(QMessageBox::tr("Could not parse desktop file translations:\nCould not open file for reading:\n\n%1").arg(fileName));
-            }
-
-            // TODO: need to make sure that this doesn't try to read huge files at once
-            auto data = jsonFile.readAll();
-
-            QJsonParseError parseError{};
-            auto jsonDoc = QJsonDocument::fromJson(data, &parseError);
-
-            // show warning on syntax errors and continue
-            if (parseError.error != QJsonParseError::NoError || jsonDoc.isNull() || !jsonDoc.isObject()) {
-                displayWarning(QMessageBox::tr("Could not parse desktop file translations:\nInvalid syntax:\n\n%1").arg(parseError.errorString()));
-            }
-
-            auto jsonObj = jsonDoc.object();
-
-            for (const auto& key : jsonObj.keys()) {
-                auto value = jsonObj[key].toString();
-                auto splitKey = key.split("/");
-
-                if (key.startsWith("Desktop Action update")) {
-                    qDebug() << "update: adding" << value << "for locale" << locale;
-                    updateActionNameTranslations[locale] = value;
-                } else if (key.startsWith("Desktop Action remove")) {
-                    qDebug() << "remove: adding" << value << "for locale" << locale;
-                    removeActionNameTranslations[locale] = value;
-                }
-            }
-        }
-    }
-#endif
+    const auto& translations = desktopActionTranslations();
 
 #ifndef BUILD_LITE
     auto privateLibDir = privateLibDirPath("ui");
@@ -812,7 +1031,7 @@ bool installDesktopFileAndIcons(const QString& pathToAppImage, bool resolveColli
         g_key_file_set_string(desktopFile.get(), removeSectionName, "Exec", removeExecPath.str().c_str());
 
         // install translations
-        auto it = QMapIterator<QString, QString>(removeActionNameTranslations);
+        auto it = QMapIterator<QString, QString>(translations.removeActionNames);
         while (it.hasNext()) {
             auto entry = it.next();
             g_key_file_set_locale_string(desktopFile.get(), removeSectionName, "Name", entry.key().toStdString().c_str(), entry.value().toStdString().c_str());
@@ -846,7 +1065,7 @@ bool installDesktopFileAndIcons(const QString& pathToAppImage, bool resolveColli
             g_key_file_set_string(desktopFile.get(), updateSectionName, "Exec", updateExecPath.str().c_str());
 
             // install translations
-            auto it = QMapIterator<QString, QString>(updateActionNameTranslations);
+            auto it = QMapIterator<QString, QString>(translations.updateActionNames);
             while (it.hasNext()) {
                 auto entry = it.next();
                 g_key_file_set_locale_string(desktopFile.get(), updateSectionName, "Name", entry.key().toStdString().c_str(), entry.value().toStdString().c_str());
@@ -865,7 +1084,7 @@ bool installDesktopFileAndIcons(const QString& pathToAppImage, bool resolveColli
     );
 
     // add version key
-    const auto version = QApplication::applicationVersion().replace("version ", "").toStdString();
+    const auto version = QCoreApplication::applicationVersion().replace("version ", "").toStdString();
     g_key_file_set_string(desktopFile.get(), G_KEY_FILE_DESKTOP_GROUP, "X-AppImageLauncher-Version", version.c_str());
 
     // save desktop file to disk
@@ -878,86 +1097,33 @@ bool installDesktopFileAndIcons(const QString& pathToAppImage, bool resolveColli
     // TODO: handle this in libappimage
     makeExecutable(desktopFilePath);
 
-    // notify KDE/Plasma about icon change
+    // record the installed files, so they can be removed without searching for them
     {
-        auto message = QDBusMessage::createSignal(QStringLiteral("/KIconLoader"), QStringLiteral("org.kde.KIconLoader"), QStringLiteral("iconChanged"));
-        message.setArguments({0});
-        QDBusConnection::sessionBus().send(message);
-    }
-
-    return true;
-}
-
-bool updateDesktopFileAndIcons(const QString& pathToAppImage) {
-    return installDesktopFileAndIcons(pathToAppImage, true);
-}
+        std::shared_ptr<char> iconValue(g_key_file_get_string(desktopFile.get(), G_KEY_FILE_DESKTOP_GROUP, G_KEY_FILE_DESKTOP_KEY_ICON, nullptr), [](char* p) {
+            g_free(p);
+        });
 
-IntegrationState integrateAppImage(const QString& pathToAppImage, const QString& pathToIntegratedAppImage) {
-    // need std::strings to get working pointers with .c_str()
-    const auto oldPath = pathToAppImage.toStdString();
-    const auto newPath = pathToIntegratedAppImage.toStdString();
-
-    // create target directory
-    QDir().mkdir(QFileInfo(QFile(pathToIntegratedAppImage)).dir().absolutePath());
-
-    // check whether AppImage is in integration directory already
-    if (QFileInfo(pathToAppImage).absoluteFilePath() != QFileInfo(pathToIntegratedAppImage).absoluteFilePath()) {
-        // need to check whether file exists
-        // if it does, the existing AppImage needs to be removed before rename can be called
-        if (QFile(pathToIntegratedAppImage).exists()) {
-            std::ostringstream message;
-            message << QObject::tr("AppImage with same filename has already been integrated.").toStdString() << std::endl
-                    << std::endl
-                    << QObject::tr("Do you wish to overwrite the existing AppImage?").toStdString() << std::endl
-                    << QObject::tr("Choosing No will run the AppImage once, and leave the system in its current state.").toStdString();
-
-            auto* messageBox = new QMessageBox(
-                QMessageBox::Warning,
-                QObject::tr("Warning"),
-                QString::fromStdString(message.str()),
-                QMessageBox::Yes | QMessageBox::No
-            );
-
-            messageBox->setDefaultButton(QMessageBox::No);
-            messageBox->show();
-
-            QApplication::exec();
-
-            if (messageBox->clickedButton() == messageBox->button(QMessageBox::No)) {
-                return INTEGRATION_ABORTED;
-            }
+        const auto digest = RegisteredDesktopFiles::pathDigest(pathToAppImage);
+        const QString iconName = iconValue != nullptr ? iconValue.get() : "";
 
-            QFile(pathToIntegratedAppImage).remove();
+        if (digest.isEmpty() || !writeIntegrationManifest(digest, pathToAppImage, desktopFilePath, iconName)) {
+            std::cerr << "[AppImageLauncher] Warning: "
+                      << "Could not write integration manifest for " << pathToAppImage.toStdString() << std::endl;
         }
+    }
 
-        if (!QFile(pathToAppImage).rename(pathToIntegratedAppImage)) {
-            auto* messageBox = new QMessageBox(
-                QMessageBox::Critical,
-                QObject::tr("Error"),
-                QObject::tr("Failed to move AppImage to target location.\n"
-                            "Try to copy AppImage instead?"),
-                QMessageBox::Ok | QMessageBox::Cancel
-            );
-
-            messageBox->setDefaultButton(QMessageBox::Ok);
-            messageBox->show();
-
-            QApplication::exec();
-
-            if (messageBox->clickedButton() == messageBox->button(QMessageBox::Cancel))
-                return INTEGRATION_FAILED;
+    if (timings != nullptr)
+        timings->desktopFileMs = timer.elapsed();
 
-            if (!QFile(pathToAppImage).copy(pathToIntegratedAppImage)) {
-                displayError("Failed to copy AppImage to target location");
-                return INTEGRATION_FAILED;
-            }
-        }
-    }
+    // notify desktop environments about icon change, if the application has set up a way to do so
+    if (iconsChangedHandler)
+        iconsChangedHandler();
 
-    if (!installDesktopFileAndIcons(pathToIntegratedAppImage))
-        return INTEGRATION_FAILED;
+    return true;
+}
 
-    return INTEGRATION_SUCCESSFUL;
+bool updateDesktopFileAndIcons(const QString& pathToAppImage) {
+    return installDesktopFileAndIcons(pathToAppImage, true);
 }
 
 QString getAppImageDigestMd5(const QString& path) {
@@ -1008,8 +1174,13 @@ QString getAppImageDigestMd5(const QString& path) {
     }
 
     if (needToCalculateDigest) {
-        // calculate digest
-        if (!appimage_type2_digest_md5(path.toStdString().c_str(), buffer.data()))
+        // calculating the digest requires reading the entire file, therefore the results are cached
+        buffer = DigestCache::defaultCache().digest(path, [](const QString& path, QByteArray& digest) {
+            digest = QByteArray(16, '\0');
+            return appimage_type2_digest_md5(path.toStdString().c_str(), digest.data());
+        });
+
+        if (buffer.size() != 16)
             return "";
     }
 
@@ -1024,7 +1195,7 @@ QString getAppImageDigestMd5(const QString& path) {
 }
 
 bool hasAlreadyBeenIntegrated(const QString& pathToAppImage) {
-    return appimage_is_registered_in_system(pathToAppImage.toStdString().c_str());
+    return RegisteredDesktopFiles::userApplications().isRegistered(pathToAppImage);
 }
 
 bool isInDirectory(const QString& pathToAppImage, const QDir& directory) {
@@ -1032,7 +1203,11 @@ bool isInDirectory(const QString& pathToAppImage, const QDir& directory) {
 }
 
 bool cleanUpOldDesktopIntegrationResources(bool verbose) {
-    auto dirPath = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/applications";
+    const auto dataLocation = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation);
+    auto dirPath = dataLocation + "/applications";
+
+    // icons of the removed desktop files which have to be looked up
+    QSet<QString> staleIconNames;
 
     auto directory = QDir(dirPath);
 
@@ -1085,30 +1260,54 @@ bool cleanUpOldDesktopIntegrationResources(bool verbose) {
             if (verbose)
                 std::cout << "AppImage no longer exists, cleaning up resources: " << appImagePath.toStdString() << std::endl;
 
+            const auto digest = RegisteredDesktopFiles::desktopFileDigest(desktopFilePath);
+
+            // AppImages integrated by this version have a manifest listing all their files
+            if (!digest.isEmpty() && hasIntegrationManifest(digest)) {
+                removeIntegrationManifestFiles(digest, verbose);
+                continue;
+            }
+
             if (verbose)
                 std::cout << "Removing desktop file: " << desktopFilePath.toStdString() << std::endl;
 
             QFile(desktopFilePath).remove();
 
-            // TODO: clean up related resources such as icons or MIME definitions
-
             auto* iconValue = g_key_file_get_string(desktopFile.get(), G_KEY_FILE_DESKTOP_GROUP, G_KEY_FILE_DESKTOP_KEY_ICON, nullptr);
 
             if (iconValue != nullptr) {
-                const auto dataLocation = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation);
-                const auto iconsPath = QString::fromStdString(dataLocation.toStdString() + "/share/icons/");
+                staleIconNames.insert(iconValue);
+                g_free(iconValue);
+            }
 
-                for (QDirIterator it(iconsPath, QDirIterator::Subdirectories); it.hasNext();) {
-                    auto path = it.next();
+            if (!digest.isEmpty()) {
+                const QDir mimePackagesDir(dataLocation + "/mime/packages");
 
-                    if (QFileInfo(path).completeBaseName().startsWith(iconValue)) {
-                        QFile::remove(path);
-                    }
+                for (const auto& fileName : mimePackagesDir.entryList({"appimagekit_" + digest + "*"}, QDir::Files)) {
+                    if (verbose)
+                        std::cout << "Removing file: " << mimePackagesDir.absoluteFilePath(fileName).toStdString() << std::endl;
+
+                    mimePackagesDir.remove(fileName);
                 }
             }
         }
     }
 
+    // without a manifest, the icons have to be looked up in the icons directory, which is walked only once for all
+    // stale desktop files
+    if (!staleIconNames.empty()) {
+        for (QDirIterator it(dataLocation + "/icons/", QDirIterator::Subdirectories); it.hasNext();) {
+            const auto path = it.next();
+
+            if (staleIconNames.contains(QFileInfo(path).completeBaseName())) {
+                if (verbose)
+                    std::cout << "Removing file: " << path.toStdString() << std::endl;
+
+                QFile::remove(path);
+            }
+        }
+    }
+
     return true;
 }
 
@@ -1125,8 +1324,8 @@ time_t getMTime(const QString& path) {
 bool desktopFileHasBeenUpdatedSinceLastUpdate(const QString& pathToAppImage) {
     const auto ownBinaryPath = getOwnBinaryPath();
 
-    const auto desktopFilePath = appimage_registered_desktop_file_path(pathToAppImage.toStdString().c_str(), nullptr, false);
-    
+    const auto desktopFilePath = RegisteredDesktopFiles::userApplications().desktopFilePath(pathToAppImage);
+
     auto ownBinaryMTime = getMTime(ownBinaryPath.get());
     auto desktopFileMTime = getMTime(desktopFilePath);
 
@@ -1142,113 +1341,11 @@ bool isAppImage(const QString& path) {
     return type > 0 && type <= 2;
 }
 
-QString which(const std::string& name) {
-    std::vector<char> command(4096);
-    snprintf(command.data(), command.size()-1, "which %s", name.c_str());
-
-    auto* proc = popen(command.data(), "r");
-
-    if (proc == nullptr)
-        throw std::runtime_error("Failed to start process for which");
-
-    std::vector<char> outBuf(4096);
-
-    fread(outBuf.data(), sizeof(char), outBuf.size()-1, proc);
-
-    pclose(proc);
-
-    QString rv(outBuf.data());
-
-    rv.replace("\n", "");
-
-    return rv;
-}
-
-void checkAuthorizationAndShowDialogIfNecessary(const QString& path, const QString& question) {
-    const uint32_t ownUid = getuid();
-    const uint32_t fileOwnerUid = QFileInfo(path).ownerId();
-    const auto fileOwnerUsername = QFileInfo(path).owner();
-
-    if (ownUid != fileOwnerUid) {
-        qDebug() << "attempting relaunch with root helper";
-
-        QString messageBoxText = QMessageBox::tr("File %1 is owned by another user: %2").arg(path).arg(fileOwnerUsername);
-        messageBoxText += "\n\n";
-        messageBoxText += question;
-
-        auto* messageBox = new QMessageBox(
-            QMessageBox::Warning,
-            QMessageBox::tr("Permissions problem"),
-            messageBoxText,
-            QMessageBox::Ok | QMessageBox::Abort,
-            nullptr
-        );
-
-        messageBox->setDefaultButton(QMessageBox::Ok);
-        messageBox->show();
-
-        QApplication::exec();
-
-        const auto relaunch = messageBox->clickedButton() == messageBox->button(QMessageBox::Ok);
-
-        if (!relaunch) {
-            qDebug() << "Dialog aborted";
-            exit(1);
-        }
-
-        qDebug() << "ok, attempting relaunch with root helper";
-
-        // pkexec doesn't retain $DISPLAY etc., as per the man page, so we can't run UI programs with it
-        for (const auto& rootHelperFilename : {/*"pkexec",*/ "gksudo", "gksu"}) {
-            const auto rootHelperPath = which(rootHelperFilename);
-            qDebug() << "trying root helper " << rootHelperFilename << rootHelperPath;
-
-            if (rootHelperPath.isEmpty())
-                continue;
-
-            qDebug() << rootHelperFilename << rootHelperPath;
-
-            std::vector<char*> argv = {
-                strdup(rootHelperPath.toStdString().c_str()),
-            };
-
-            if (fileOwnerUid != 0) {
-                argv.emplace_back(strdup("--user"));
-                argv.emplace_back(strdup(std::to_string(fileOwnerUid).c_str()));
-            }
-
-            for (const auto& arg : QCoreApplication::arguments()) {
-                argv.emplace_back(strdup(arg.toStdString().c_str()));
-            }
-
-            argv.emplace_back(nullptr);
-
-            const auto rv = execv(strdup(rootHelperPath.toStdString().c_str()), argv.data());
-
-            // if the execution fails, we should signalize this to the user instead of silently failing over to the
-            // next tool
-            QMessageBox::critical(
-                    nullptr,
-                    QMessageBox::tr("Error"),
-                    QMessageBox::tr("Failed to run permissions helper, exited with return code %1").arg(rv)
-            );
-            exit(1);
-        }
-
-        QMessageBox::critical(
-            nullptr,
-            QMessageBox::tr("Error"),
-            QMessageBox::tr("Could not find suitable permissions helper, aborting")
-        );
-        exit(1);
-    }
-}
-
 QString pathToPrivateDataDirectory() {
     // first we need to find the translation directory
     // if this is run from the build tree, we try a path that can only work within the build directory
     // then, we try the expected install location relative to the main binary
-    const auto binaryDirPath = QApplication::applicationDirPath();
+    const auto binaryDirPath = QCoreApplication::applicationDirPath();
 
     // our helper tools are not shipped in usr/bin but usr/lib/<arch>-linux-gnu/appimagelauncher
     // therefore we need to check for the translations directory relative to this directory as well
@@ -1273,87 +1370,29 @@ QString pathToPrivateDataDirectory() {
     return dataDir;
 }
 
-bool unregisterAppImage(const QString& pathToAppImage) {
-    auto rv = appimage_unregister_in_system(pathToAppImage.toStdString().c_str(), false);
-
-    if (rv != 0)
-        return false;
-
-    return true;
-}
-
-QIcon loadIconWithFallback(const QString& iconName) {
-    const QString subdirName("fallback-icons");
-    const auto binaryDir = QApplication::applicationDirPath();
-
-    // first we check the directory that would be expected with in the build environment
-    QDir fallbackIconDirectory = QDir(binaryDir + "/../../resources/" + subdirName);
-
-    // if that doesn't work, we check the private data directory, which should work when AppImageLauncher is installed
-    // through the packages or in Lite's AppImage
-    if (!fallbackIconDirectory.exists()) {
-        auto privateDataDir = pathToPrivateDataDirectory();
-
-        if (privateDataDir.length() > 0 && QDir(privateDataDir).exists()) {
-            fallbackIconDirectory = QDir(pathToPrivateDataDirectory() + "/" + subdirName);
-        }
-    }
-
-    // fallback icons aren't critical enough to exit the application if they can't be found
-    // after all, the theme icons may work just as well
-    if (!fallbackIconDirectory.exists()) {
-        std::cerr << "[AppImageLauncher] Warning:"
-                  << "fallback icons could not be loaded: directory could not be found" << std::endl;
-        return QIcon{};
-    }
-
-    qDebug() << "Loading fallback for icon" << iconName;
+QString pathToCacheDirectory() {
+    const auto cacheDir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/appimagelauncher";
 
-    const auto iconFilename = iconName + ".svg";
-    const auto iconPath = fallbackIconDirectory.filePath(iconFilename);
-
-    if (!QFileInfo(iconPath).isFile()) {
-        std::cerr << "[AppImageLauncher] Warning: can't find fallback icon for name"
-                  << iconName.toStdString() << std::endl;
-        return QIcon{};
+    if (!QDir().mkpath(cacheDir)) {
+        std::cerr << "[AppImageLauncher] Warning: "
+                  << "Could not create cache directory " << cacheDir.toStdString() << std::endl;
     }
 
-    const auto fallbackIcon = QIcon(iconPath);
-    qDebug() << fallbackIcon;
-
-    return fallbackIcon;
+    return cacheDir;
 }
 
-void setUpFallbackIconPaths(QWidget* parent) {
-    /**
-     * Qt 5.12 adds a feature to add fallback paths for icons. This is a very simple way to automatically load custom
-     * icons when the icon theme doesn't provide a suitable alternative.
-     * However, we need to support a much older Qt version. Therefore we cannot use this very very handy feature.
-     * We basically iterate over all buttons which carry an icon and (re)load it, but this time provide a fallback
-     * loaded from our private data directory.
-     */
-
-    // for now we only support buttons
-    // we could always add more widgets which provide an icon property
-    const auto buttons = parent->findChildren<QAbstractButton*>();
-
-    for (const auto& button : buttons) {
-        const auto iconName = button->icon().name();
+bool unregisterAppImage(const QString& pathToAppImage) {
+    const auto digest = RegisteredDesktopFiles::pathDigest(pathToAppImage);
 
-        // sort out buttons without an icon
-        if (iconName.length() <= 0)
-            continue;
+    // if the files are known, they can be removed directly, libappimage would have to search for them
+    if (!digest.isEmpty() && hasIntegrationManifest(digest))
+        return removeIntegrationManifestFiles(digest);
 
-        // load icon from theme, providing the bundled icon as a fallback
-        // loading an "empty" (i.e., isNull() returns true) icon as fallback, as returned by loadIconWithFallback(...),
-        // works just fine
-        auto fallbackIcon = loadIconWithFallback(iconName);
-        auto newIcon = QIcon::fromTheme(iconName, fallbackIcon);
+    auto rv = appimage_unregister_in_system(pathToAppImage.toStdString().c_str(), false);
 
-        if (newIcon.isNull() || newIcon.pixmap(16, 16).isNull())
-            newIcon = fallbackIcon;
+    if (rv != 0)
+        return false;
 
-        // now replace the button's actual icon with the fallback-enabled one
-        button->setIcon(newIcon);
-    }
+    return true;
 }
+
@@ -3,6 +3,7 @@
 #pragma once
 
 // system headers
+#include <functional>
 #include <string>
 #include <memory>
 
@@ -24,12 +25,28 @@ enum IntegrationState {
 // currently hardcoded, can not be changed by users
 static const auto DEFAULT_INTEGRATION_DESTINATION = QString(getenv("HOME")) + "/Applications/";
 
+enum MessageSeverity {
+    MESSAGE_WARNING = 0,
+    MESSAGE_ERROR,
+};
+
+// receives the messages passed to displayWarning(...) and displayError(...)
+typedef std::function<void(MessageSeverity severity, const QString& message)> MessageHandler;
+
 // little convenience method to display warnings
 void displayWarning(const QString& message);
 
 // little convenience method to display errors
 void displayError(const QString& message);
 
+// by default, warnings and errors are printed to stderr
+// graphical applications can install a handler showing them in message boxes (see shared_ui.h)
+void setMessageHandler(MessageHandler handler);
+
+// installDesktopFileAndIcons(...) calls this handler after it installed a desktop file and its icons, e.g., to notify
+// desktop environments which don't watch the icon directories (see shared_dbus.h)
+void setIconsChangedHandler(std::function<void()> handler);
+
 // reliable way to check if the current session is graphical or not
 bool isHeadless();
 
@@ -44,22 +61,39 @@ bool makeNonExecutable(const QString& path);
 QString privateLibDirPath(const QString& srcSubdirName);
 #endif
 
+// durations of the steps of installDesktopFileAndIcons(...) in milliseconds, -1 if a step hasn't been reached
+struct DesktopIntegrationTimings {
+    // registration of desktop file, icons and MIME types via libappimage
+    qint64 registerMs = -1;
+    // AppImageLauncher specific modifications of the desktop file
+    qint64 desktopFileMs = -1;
+};
+
 // installs desktop file for given AppImage, including AppImageLauncher specific modifications
 // set resolveCollisions to false in order to leave the Name entries as-is
-bool installDesktopFileAndIcons(const QString& pathToAppImage, bool resolveCollisions = true);
+// if timings is passed, the durations of the individual steps are recorded in there
+bool installDesktopFileAndIcons(const QString& pathToAppImage, bool resolveCollisions = true,
+                                DesktopIntegrationTimings* timings = nullptr);
 
 // update AppImage's existing desktop file with AppImageLauncher specific entries
 // this alias for installDesktopFileAndIcons does not perform any collision detection and resolving
 bool updateDesktopFileAndIcons(const QString& pathToAppImage);
 
+// categories of files whose caches are updated by updateDesktopDatabaseAndIconCaches(...)
+enum DesktopCacheCategory {
+    DESKTOP_FILES_CACHE = 1 << 0,
+    ICONS_CACHE = 1 << 1,
+    MIME_TYPES_CACHE = 1 << 2,
+    ALL_DESKTOP_CACHES = DESKTOP_FILES_CACHE | ICONS_CACHE | MIME_TYPES_CACHE,
+};
+
 // update desktop database and icon caches of desktop environments
 // this makes sure that:
 //   - outdated entries are removed from the launcher
 //   - icons of freshly integrated AppImages are displayed in the launcher
-bool updateDesktopDatabaseAndIconCaches();
-
-// integrates an AppImage using a standard workflow used across all AppImageLauncher applications
-IntegrationState integrateAppImage(const QString& pathToAppImage, const QString& pathToIntegratedAppImage);
+// categories is a combination of DesktopCacheCategory values
+// the caches of a category are updated only if its files changed since the last update in this process
+bool updateDesktopDatabaseAndIconCaches(int categories = ALL_DESKTOP_CACHES);
 
 // write config file to standard location with given configuration values
 // askToMove and enableDaemon both are bools but represented as int to add some sort of "unset" state
@@ -68,6 +102,9 @@ IntegrationState integrateAppImage(const QString& pathToAppImage, const QString&
 void createConfigFile(int askToMove, const QString& destination, int enableDaemon,
                       const QStringList& additionalDirsToWatch = {}, int monitorMountedFilesystems = -1);
 
+// path to the config file, which might not exist yet
+QString getConfigFilePath();
+
 // replaces ~ character in paths with real home directory, if necessary and possible
 QString expandTilde(QString path);
 
@@ -81,6 +118,16 @@ QDir integratedAppImagesDestination();
 // to move to the main location, if they're in one of these, it's all good)
 QSet<QString> additionalAppImagesLocations(bool includeValidMountPoints = false);
 
+// checks whether the Applications directory of the given mounted filesystem is one of the additional locations, i.e.,
+// whether it's a "native" filesystem of a supported type on a real device
+bool isAppImagesLocationMount(const QString& device, const QString& mountPoint, const QString& fsType);
+
+// checks whether the Applications directories of mounted filesystems shall be watched as well
+bool shallMonitorMountedFilesystems(std::shared_ptr<QSettings> config);
+
+// additional directories to watch listed in the config file, skipping the ones which don't exist
+QDirSet getAdditionalDirectoriesFromConfig(const std::shared_ptr<QSettings>& config);
+
 // calculate list of directories the daemon has to watch
 // AppImages inside there should furthermore not be moved out of there and into the main integration directory
 QDirSet daemonDirectoriesToWatch(const std::shared_ptr<QSettings>& config = nullptr);
@@ -111,23 +158,13 @@ bool desktopFileHasBeenUpdatedSinceLastUpdate(const QString& pathToAppImage);
 // checks whether a file is an AppImage
 bool isAppImage(const QString& path);
 
-// when a file doesn't belong to the current user, this method shows a dialog asking whether to relaunch as that user
-// this can be used when e.g., updating AppImages owned by root or other users
-// uses pkexec, gksudo, gksu etc., whatever is available
-// the second argument is the question that will be asked in the dialog displayed in case a relaunch is necessary
-void checkAuthorizationAndShowDialogIfNecessary(const QString& path, const QString& question);
-
 // searchs for path to private data directory relative to the current binary's location
 // returns empty string if the path cannot be found
 QString pathToPrivateDataDirectory();
 
+// path to the directory AppImageLauncher stores its caches in ($XDG_CACHE_HOME/appimagelauncher)
+// the directory is created if necessary
+QString pathToCacheDirectory();
+
 // clean up desktop integration files installed while originally integrating the AppImage
 bool unregisterAppImage(const QString& pathToAppImage);
-
-// try to load icon with provided name from AppImageLauncher's fallback icons directory
-// returns empty QIcon if such an icon cannot be found
-// you can check for errors by calling QIcon::isNull()
-QIcon loadIconWithFallback(const QString& iconName);
-
-// sets up paths to fallback icons bundled with AppImageLauncher
-void setUpFallbackIconPaths(QWidget*);
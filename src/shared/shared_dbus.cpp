@@ -0,0 +1,70 @@
+// library includes
+#include <QDBusConnection>
+#include <QDBusError>
+#include <QDBusMessage>
+#include <QDebug>
+
+// local headers
+#include "shared_dbus.h"
+#include "daemondbusinterface.h"
+
+static DaemonRequestResult sendRequestToDaemon(const QString& method, const QStringList& paths,
+                                               bool waitForCompletion) {
+    // integrating many AppImages may take a while, but we don't want to wait forever for a daemon which got stuck
+    static constexpr int timeout = 10 * 60 * 1000;
+
+    auto connection = QDBusConnection::sessionBus();
+
+    if (!connection.isConnected())
+        return DAEMON_UNAVAILABLE;
+
+    auto message = QDBusMessage::createMethodCall(
+        APPIMAGELAUNCHERD_DBUS_SERVICE, APPIMAGELAUNCHERD_DBUS_PATH, APPIMAGELAUNCHERD_DBUS_INTERFACE, method
+    );
+    message << paths << waitForCompletion;
+
+    // only a daemon that's running already is of any use
+    message.setAutoStartService(false);
+
+    const auto reply = connection.call(message, QDBus::Block, timeout);
+
+    if (reply.type() == QDBusMessage::ErrorMessage) {
+        const auto error = QDBusError(reply).type();
+
+        // there's no daemon running
+        if (error == QDBusError::ServiceUnknown || error == QDBusError::NameHasNoOwner)
+            return DAEMON_UNAVAILABLE;
+
+        // the daemon might still be working on the request (e.g., after a timeout), so the caller must not do the
+        // same work in parallel
+        qDebug() << "Daemon request failed:" << reply.errorName() << reply.errorMessage();
+        return DAEMON_REQUEST_FAILED;
+    }
+
+    if (reply.type() != QDBusMessage::ReplyMessage || reply.arguments().isEmpty()) {
+        qDebug() << "Invalid reply from daemon";
+        return DAEMON_REQUEST_FAILED;
+    }
+
+    if (!reply.arguments().first().toBool())
+        return DAEMON_REQUEST_FAILED;
+
+    return DAEMON_REQUEST_SUCCEEDED;
+}
+
+DaemonRequestResult requestIntegrationFromDaemon(const QStringList& paths, bool waitForCompletion) {
+    return sendRequestToDaemon("Integrate", paths, waitForCompletion);
+}
+
+DaemonRequestResult requestUnintegrationFromDaemon(const QStringList& paths, bool waitForCompletion) {
+    return sendRequestToDaemon("Unintegrate", paths, waitForCompletion);
+}
+
+void installIconsChangedNotifier() {
+    setIconsChangedHandler([]() {
+        // notify KDE/Plasma about icon change
+        auto message = QDBusMessage::createSignal(QStringLiteral("/KIconLoader"), QStringLiteral("org.kde.KIconLoader"), QStringLiteral("iconChanged"));
+        message.setArguments({0});
+        QDBusConnection::sessionBus().send(message);
+    });
+}
@@ -0,0 +1,29 @@
+/* utility functions which communicate over the session bus */
+
+#pragma once
+
+// library headers
+#include <QStringList>
+
+// local headers
+#include "shared.h"
+
+enum DaemonRequestResult {
+    // no daemon is running
+    DAEMON_UNAVAILABLE = 0,
+    DAEMON_REQUEST_SUCCEEDED,
+    // the daemon has reported a failure, or the request failed otherwise (e.g., timed out)
+    DAEMON_REQUEST_FAILED,
+};
+
+// hand the (un)integration of AppImages over to the running appimagelauncherd, which batches requests from all clients
+// if waitForCompletion is set, the call blocks until the daemon has processed all of them, otherwise it returns as soon
+// as the daemon has accepted the request
+// paths must be absolute
+// in case the daemon is unavailable, the caller is expected to do the work itself
+DaemonRequestResult requestIntegrationFromDaemon(const QStringList& paths, bool waitForCompletion = true);
+DaemonRequestResult requestUnintegrationFromDaemon(const QStringList& paths, bool waitForCompletion = true);
+
+// notifies KDE/Plasma, which doesn't watch the icon directories, whenever installDesktopFileAndIcons(...) installed
+// new icons
+void installIconsChangedNotifier();
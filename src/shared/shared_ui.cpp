@@ -0,0 +1,293 @@
+// system includes
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+extern "C" {
+    #include <stdio.h>
+    #include <unistd.h>
+}
+
+// library includes
+#include <QAbstractButton>
+#include <QApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QIcon>
+#include <QMessageBox>
+#include <QPixmap>
+
+// local headers
+#include "shared_ui.h"
+
+// avoids code duplication, and works for both graphical and non-graphical environments
+static void displayMessageBox(const QString& title, const QString& message, const QMessageBox::Icon icon) {
+    if (isHeadless()) {
+        std::cerr << title.toStdString() << ": " << message.toStdString() << std::endl;
+    } else {
+        // little complex, can't use QMessageBox::{critical,warning,...} for the same reason as in main()
+        auto* mb = new QMessageBox(icon, title, message, QMessageBox::Ok, nullptr);
+        mb->show();
+        QApplication::exec();
+    }
+}
+
+void installMessageBoxHandler() {
+    setMessageHandler([](MessageSeverity severity, const QString& message) {
+        if (severity == MESSAGE_ERROR) {
+            displayMessageBox(QObject::tr("Error"), message, QMessageBox::Critical);
+        } else {
+            displayMessageBox(QObject::tr("Warning"), message, QMessageBox::Warning);
+        }
+    });
+}
+
+IntegrationState integrateAppImage(const QString& pathToAppImage, const QString& pathToIntegratedAppImage) {
+    // need std::strings to get working pointers with .c_str()
+    const auto oldPath = pathToAppImage.toStdString();
+    const auto newPath = pathToIntegratedAppImage.toStdString();
+
+    // create target directory
+    QDir().mkdir(QFileInfo(QFile(pathToIntegratedAppImage)).dir().absolutePath());
+
+    // check whether AppImage is in integration directory already
+    if (QFileInfo(pathToAppImage).absoluteFilePath() != QFileInfo(pathToIntegratedAppImage).absoluteFilePath()) {
+        // need to check whether file exists
+        // if it does, the existing AppImage needs to be removed before rename can be called
+        if (QFile(pathToIntegratedAppImage).exists()) {
+            std::ostringstream message;
+            message << QObject::tr("AppImage with same filename has already been integrated.").toStdString() << std::endl
+                    << std::endl
+                    << QObject::tr("Do you wish to overwrite the existing AppImage?").toStdString() << std::endl
+                    << QObject::tr("Choosing No will run the AppImage once, and leave the system in its current state.").toStdString();
+
+            auto* messageBox = new QMessageBox(
+                QMessageBox::Warning,
+                QObject::tr("Warning"),
+                QString::fromStdString(message.str()),
+                QMessageBox::Yes | QMessageBox::No
+            );
+
+            messageBox->setDefaultButton(QMessageBox::No);
+            messageBox->show();
+
+            QApplication::exec();
+
+            if (messageBox->clickedButton() == messageBox->button(QMessageBox::No)) {
+                return INTEGRATION_ABORTED;
+            }
+
+            QFile(pathToIntegratedAppImage).remove();
+        }
+
+        if (!QFile(pathToAppImage).rename(pathToIntegratedAppImage)) {
+            auto* messageBox = new QMessageBox(
+                QMessageBox::Critical,
+                QObject::tr("Error"),
+                QObject::tr("Failed to move AppImage to target location.\n"
+                            "Try to copy AppImage instead?"),
+                QMessageBox::Ok | QMessageBox::Cancel
+            );
+
+            messageBox->setDefaultButton(QMessageBox::Ok);
+            messageBox->show();
+
+            QApplication::exec();
+
+            if (messageBox->clickedButton() == messageBox->button(QMessageBox::Cancel))
+                return INTEGRATION_FAILED;
+
+            if (!QFile(pathToAppImage).copy(pathToIntegratedAppImage)) {
+                displayError("Failed to copy AppImage to target location");
+                return INTEGRATION_FAILED;
+            }
+        }
+    }
+
+    if (!installDesktopFileAndIcons(pathToIntegratedAppImage))
+        return INTEGRATION_FAILED;
+
+    return INTEGRATION_SUCCESSFUL;
+}
+
+static QString which(const std::string& name) {
+    std::vector<char> command(4096);
+    snprintf(command.data(), command.size()-1, "which %s", name.c_str());
+
+    auto* proc = popen(command.data(), "r");
+
+    if (proc == nullptr)
+        throw std::runtime_error("Failed to start process for which");
+
+    std::vector<char> outBuf(4096);
+
+    fread(outBuf.data(), sizeof(char), outBuf.size()-1, proc);
+
+    pclose(proc);
+
+    QString rv(outBuf.data());
+
+    rv.replace("\n", "");
+
+    return rv;
+}
+
+void checkAuthorizationAndShowDialogIfNecessary(const QString& path, const QString& question) {
+    const uint32_t ownUid = getuid();
+    const uint32_t fileOwnerUid = QFileInfo(path).ownerId();
+    const auto fileOwnerUsername = QFileInfo(path).owner();
+
+    if (ownUid != fileOwnerUid) {
+        qDebug() << "attempting relaunch with root helper";
+
+        QString messageBoxText = QMessageBox::tr("File %1 is owned by another user: %2").arg(path).arg(fileOwnerUsername);
+        messageBoxText += "\n\n";
+        messageBoxText += question;
+
+        auto* messageBox = new QMessageBox(
+            QMessageBox::Warning,
+            QMessageBox::tr("Permissions problem"),
+            messageBoxText,
+            QMessageBox::Ok | QMessageBox::Abort,
+            nullptr
+        );
+
+        messageBox->setDefaultButton(QMessageBox::Ok);
+        messageBox->show();
+
+        QApplication::exec();
+
+        const auto relaunch = messageBox->clickedButton() == messageBox->button(QMessageBox::Ok);
+
+        if (!relaunch) {
+            qDebug() << "Dialog aborted";
+            exit(1);
+        }
+
+        qDebug() << "ok, attempting relaunch with root helper";
+
+        // pkexec doesn't retain $DISPLAY etc., as per the man page, so we can't run UI programs with it
+        for (const auto& rootHelperFilename : {/*"pkexec",*/ "gksudo", "gksu"}) {
+            const auto rootHelperPath = which(rootHelperFilename);
+            qDebug() << "trying root helper " << rootHelperFilename << rootHelperPath;
+
+            if (rootHelperPath.isEmpty())
+                continue;
+
+            qDebug() << rootHelperFilename << rootHelperPath;
+
+            std::vector<char*> argv = {
+                strdup(rootHelperPath.toStdString().c_str()),
+            };
+
+            if (fileOwnerUid != 0) {
+                argv.emplace_back(strdup("--user"));
+                argv.emplace_back(strdup(std::to_string(fileOwnerUid).c_str()));
+            }
+
+            for (const auto& arg : QCoreApplication::arguments()) {
+                argv.emplace_back(strdup(arg.toStdString().c_str()));
+            }
+
+            argv.emplace_back(nullptr);
+
+            const auto rv = execv(strdup(rootHelperPath.toStdString().c_str()), argv.data());
+
+            // if the execution fails, we should signalize this to the user instead of silently failing over to the
+            // next tool
+            QMessageBox::critical(
+                    nullptr,
+                    QMessageBox::tr("Error"),
+                    QMessageBox::tr("Failed to run permissions helper, exited with return code %1").arg(rv)
+            );
+            exit(1);
+        }
+
+        QMessageBox::critical(
+            nullptr,
+            QMessageBox::tr("Error"),
+            QMessageBox::tr("Could not find suitable permissions helper, aborting")
+        );
+        exit(1);
+    }
+}
+
+QIcon loadIconWithFallback(const QString& iconName) {
+    const QString subdirName("fallback-icons");
+    const auto binaryDir = QCoreApplication::applicationDirPath();
+
+    // first we check the directory that would be expected with in the build environment
+    QDir fallbackIconDirectory = QDir(binaryDir + "/../../resources/" + subdirName);
+
+    // if that doesn't work, we check the private data directory, which should work when AppImageLauncher is installed
+    // through the packages or in Lite's AppImage
+    if (!fallbackIconDirectory.exists()) {
+        auto privateDataDir = pathToPrivateDataDirectory();
+
+        if (privateDataDir.length() > 0 && QDir(privateDataDir).exists()) {
+            fallbackIconDirectory = QDir(pathToPrivateDataDirectory() + "/" + subdirName);
+        }
+    }
+
+    // fallback icons aren't critical enough to exit the application if they can't be found
+    // after all, the theme icons may work just as well
+    if (!fallbackIconDirectory.exists()) {
+        std::cerr << "[AppImageLauncher] Warning:"
+                  << "fallback icons could not be loaded: directory could not be found" << std::endl;
+        return QIcon{};
+    }
+
+    qDebug() << "Loading fallback for icon" << iconName;
+
+    const auto iconFilename = iconName + ".svg";
+    const auto iconPath = fallbackIconDirectory.filePath(iconFilename);
+
+    if (!QFileInfo(iconPath).isFile()) {
+        std::cerr << "[AppImageLauncher] Warning: can't find fallback icon for name"
+                  << iconName.toStdString() << std::endl;
+        return QIcon{};
+    }
+
+    const auto fallbackIcon = QIcon(iconPath);
+    qDebug() << fallbackIcon;
+
+    return fallbackIcon;
+}
+
+void setUpFallbackIconPaths(QWidget* parent) {
+    /**
+     * Qt 5.12 adds a feature to add fallback paths for icons. This is a very simple way to automatically load custom
+     * icons when the icon theme doesn't provide a suitable alternative.
+     * However, we need to support a much older Qt version. Therefore we cannot use this very very handy feature.
+     * We basically iterate over all buttons which carry an icon and (re)load it, but this time provide a fallback
+     * loaded from our private data directory.
+     */
+
+    // for now we only support buttons
+    // we could always add more widgets which provide an icon property
+    const auto buttons = parent->findChildren<QAbstractButton*>();
+
+    for (const auto& button : buttons) {
+        const auto iconName = button->icon().name();
+
+        // sort out buttons without an icon
+        if (iconName.length() <= 0)
+            continue;
+
+        // load icon from theme, providing the bundled icon as a fallback
+        // loading an "empty" (i.e., isNull() returns true) icon as fallback, as returned by loadIconWithFallback(...),
+        // works just fine
+        auto fallbackIcon = loadIconWithFallback(iconName);
+        auto newIcon = QIcon::fromTheme(iconName, fallbackIcon);
+
+        if (newIcon.isNull() || newIcon.pixmap(16, 16).isNull())
+            newIcon = fallbackIcon;
+
+        // now replace the button's actual icon with the fallback-enabled one
+        button->setIcon(newIcon);
+    }
+}
@@ -0,0 +1,32 @@
+/* utility functions shared by AppImageLauncher's graphical applications */
+
+#pragma once
+
+// library headers
+#include <QIcon>
+#include <QString>
+#include <QWidget>
+
+// local headers
+#include "shared.h"
+
+// shows warnings and errors passed to displayWarning(...) and displayError(...) in message boxes, unless the session
+// is headless
+void installMessageBoxHandler();
+
+// integrates an AppImage using a standard workflow used across all AppImageLauncher applications
+IntegrationState integrateAppImage(const QString& pathToAppImage, const QString& pathToIntegratedAppImage);
+
+// when a file doesn't belong to the current user, this method shows a dialog asking whether to relaunch as that user
+// this can be used when e.g., updating AppImages owned by root or other users
+// uses pkexec, gksudo, gksu etc., whatever is available
+// the second argument is the question that will be asked in the dialog displayed in case a relaunch is necessary
+void checkAuthorizationAndShowDialogIfNecessary(const QString& path, const QString& question);
+
+// try to load icon with provided name from AppImageLauncher's fallback icons directory
+// returns empty QIcon if such an icon cannot be found
+// you can check for errors by calling QIcon::isNull()
+QIcon loadIconWithFallback(const QString& iconName);
+
+// sets up paths to fallback icons bundled with AppImageLauncher
+void setUpFallbackIconPaths(QWidget*);
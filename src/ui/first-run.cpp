@@ -19,6 +19,7 @@
 // local includes
 #include "ui_first-run.h"
 #include "shared.h"
+#include "shared_ui.h"
 
 
 class FirstRunDialog : public QDialog {
@@ -30,6 +30,8 @@ extern "C" {
 
 // local headers
 #include "shared.h"
+#include "shared_dbus.h"
+#include "shared_ui.h"
 #include "trashbin.h"
 #include "translationmanager.h"
 #include "first-run.h"
@@ -143,6 +145,10 @@ int main(int argc, char** argv) {
     // Use a fake argc value to avoid QApplication from modifying the arguments
     QCoreApplication* app = getApp(argv);
 
+    // show warnings and errors in message boxes, and notify desktop environments about new icons
+    installMessageBoxHandler();
+    installIconsChangedNotifier();
+
     // install translations
     TranslationManager translationManager(*app);
 
@@ -338,12 +344,15 @@ int main(int argc, char** argv) {
             // in case there was an update of AppImageLauncher, we should should also update the desktop database
             // and icon caches
             if (!desktopFileHasBeenUpdatedSinceLastUpdate(pathToAppImage)) {
-                if (!updateDesktopFileAndIcons(pathToAppImage))
-                    return 1;
-
-                // make sure the icons in the launcher are refreshed after updating the desktop file
-                if (!updateDesktopDatabaseAndIconCaches())
-                    return 1;
+                // if the daemon is running, we can leave the update to it, and run the AppImage right away
+                if (requestIntegrationFromDaemon({pathToAppImage}, false) == DAEMON_UNAVAILABLE) {
+                    if (!updateDesktopFileAndIcons(pathToAppImage))
+                        return 1;
+
+                    // make sure the icons in the launcher are refreshed after updating the desktop file
+                    if (!updateDesktopDatabaseAndIconCaches())
+                        return 1;
+                }
             }
             return runAppImage(pathToAppImage, appImageArgv.size(), appImageArgv.data());
         };
@@ -405,7 +414,7 @@ int main(int argc, char** argv) {
             // if the user selects No, then continue as if the AppImage would not be in this directory
             if (messageBox->clickedButton() == messageBox->button(QMessageBox::Yes)) {
                 // unregister AppImage, move, and re-integrate
-                if (appimage_unregister_in_system(pathToAppImage.toStdString().c_str(), false) != 0) {
+                if (!unregisterAppImage(pathToAppImage)) {
                     displayError(QMessageBox::tr("Failed to unregister AppImage before re-integrating it"));
                     return 1;
                 }
@@ -20,6 +20,7 @@ extern "C" {
 
 // local includes
 #include "shared.h"
+#include "shared_ui.h"
 #include "translationmanager.h"
 #include "trashbin.h"
 #include "ui_remove.h"
@@ -28,6 +29,7 @@ int main(int argc, char** argv) {
     QCommandLineParser parser;
     parser.setApplicationDescription(QObject::tr("Helper to delete integrated AppImages easily, e.g., from the application launcher's context menu"));
     QApplication app(argc, argv);
+    installMessageBoxHandler();
     QApplication::setApplicationDisplayName("AppImageLauncher");
     QApplication::setWindowIcon(QIcon(":/AppImageLauncher.svg"));
 
@@ -8,6 +8,7 @@
 #include "settings_dialog.h"
 #include "ui_settings_dialog.h"
 #include "shared.h"
+#include "shared_ui.h"
 
 SettingsDialog::SettingsDialog(QWidget* parent) :
         QDialog(parent),
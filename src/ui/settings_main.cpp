@@ -4,10 +4,12 @@
 // local
 #include <translationmanager.h>
 #include <shared.h>
+#include <shared_ui.h>
 #include "settings_dialog.h"
 
 int main(int argc, char** argv) {
     QApplication app(argc, argv);
+    installMessageBoxHandler();
     QApplication::setApplicationDisplayName("AppImageLauncher Settings");
     QApplication::setWindowIcon(QIcon(":/AppImageLauncher.svg"));
 
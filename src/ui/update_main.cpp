@@ -21,6 +21,8 @@ extern "C" {
 
 // local includes
 #include "shared.h"
+#include "shared_dbus.h"
+#include "shared_ui.h"
 #include "translationmanager.h"
 
 
@@ -29,6 +31,8 @@ int main(int argc, char** argv) {
     parser.setApplicationDescription(QObject::tr("Updates AppImages after desktop integration, for use by Linux distributions"));
 
     QApplication app(argc, argv);
+    installMessageBoxHandler();
+    installIconsChangedNotifier();
     QApplication::setApplicationDisplayName(QObject::tr("AppImageLauncher update", "update helper app name"));
     QApplication::setWindowIcon(QIcon(":/AppImageLauncher.svg"));
 
@@ -194,7 +198,7 @@ int main(int argc, char** argv) {
         // in this case, a warning is shown, asking the user whether to overwrite the old file, and in that case we
         // don't need to unregister nor delete the file
         if (pathToIntegratedAppImage != pathToIntegratedUpdatedAppImage) {
-            if (appimage_unregister_in_system(pathToAppImage.toStdString().c_str(), false) != 0) {
+            if (!unregisterAppImage(pathToAppImage)) {
                 criticalUpdaterError(QObject::tr("Failed to unregister old AppImage in system"));
                 return 1;
             }